@@ -0,0 +1,243 @@
+/*------------------------------------------------------------------------------
+ * dmxtest.c : stream demultiplexer block length test (host)
+ *
+ * description : generate a corrupted mixed stream of ubx, nmea and rtcm 3
+ *               frames (flipped bytes, frames truncated as by a uart overrun,
+ *               false preambles declaring long frames and random gaps) and
+ *               input it to the demultiplexer (demux.c) in 1-byte blocks, in
+ *               blocks of random length and as one block of the whole stream.
+ *               the test fails unless all runs find the same frames (number,
+ *               protocol and contents) with the same checksum errors and
+ *               skipped bytes, so a frame recovered in a block and lost over
+ *               a block end shows as a difference.
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o dmxtest dmxtest.c ../../RTKLIB/demux.c
+ *              ../../RTKLIB/ublox.c ../../RTKLIB/rcvraw.c ../../RTKLIB/rtkcmn.c
+ *              ../../RTKLIB/sbas.c ../../RTKLIB/ubxlog.c -lm
+ *
+ * usage  : dmxtest [-n num] [-s seed]
+ *          -n num      number of frames (default 20000)
+ *          -s seed     random seed (default 1)
+ *
+ *          exit status 0: ok, 1: test failed
+ *
+ *-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+#define MAXGAP 16   /* max bytes between frames */
+#define MAXPAY 300  /* max payload of generated frames (bytes) */
+#define NRUN 3      /* number of runs (1-byte, random, whole stream) */
+
+typedef struct
+{                            /* demux run result type */
+    demux_t dmx;             /* stream demultiplexer */
+    unsigned int nfrm;       /* number of valid frames */
+    unsigned int hash;       /* hash of valid frames */
+} run_t;
+
+static run_t *cur;           /* current run */
+
+/* valid frame callback: hash of protocol and frame --------------------------*/
+static void dmxfunc(int type, const unsigned char *frm, int len)
+{
+    unsigned int h = cur->hash * 31 + (unsigned int)type;
+    int i;
+
+    for (i = 0; i < len; i++)
+        h = h * 31 + frm[i];
+    cur->hash = h;
+    cur->nfrm++;
+}
+/* generate ubx frame --------------------------------------------------------*/
+static int genubx(unsigned char *buff)
+{
+    unsigned char cka = 0, ckb = 0;
+    int i, len = rand() % MAXPAY;
+
+    buff[0] = 0xB5;
+    buff[1] = 0x62;
+    buff[2] = (unsigned char)(rand() % 16);
+    buff[3] = (unsigned char)rand();
+    buff[4] = (unsigned char)len;
+    buff[5] = (unsigned char)(len >> 8);
+    for (i = 0; i < len; i++)
+        buff[6 + i] = (unsigned char)rand();
+    for (i = 2; i < len + 6; i++)
+    {
+        cka += buff[i];
+        ckb += cka;
+    }
+    buff[len + 6] = cka;
+    buff[len + 7] = ckb;
+    return len + 8;
+}
+/* generate nmea sentence ----------------------------------------------------*/
+static int gennmea(unsigned char *buff)
+{
+    unsigned char sum = 0;
+    int i, n = rand() % 70 + 6;
+
+    buff[0] = '$';
+    for (i = 1; i < n; i++)
+    {
+        buff[i] = (unsigned char)(rand() % 2 ? 'A' + rand() % 26 : ',');
+        sum ^= buff[i];
+    }
+    return n + sprintf((char *)buff + n, "*%02X\r\n", sum);
+}
+/* generate rtcm 3 frame -----------------------------------------------------*/
+static int genrtcm3(unsigned char *buff)
+{
+    unsigned int crc;
+    int i, len = rand() % MAXPAY;
+
+    buff[0] = RTCM3PREAMB;
+    buff[1] = (unsigned char)(len >> 8);
+    buff[2] = (unsigned char)len;
+    for (i = 0; i < len; i++)
+        buff[3 + i] = (unsigned char)rand();
+    crc = crc24q(buff, len + 3);
+    setbitu(buff, (len + 3) * 8, 24, crc);
+    return len + 6;
+}
+/* generate false preamble declaring long frame ------------------------------*/
+static int genfalse(unsigned char *buff)
+{
+    int len;
+
+    switch (rand() % 3)
+    {
+    case 0:
+        len = rand() % (MAXRAWLEN - 8);
+        buff[0] = 0xB5;
+        buff[1] = 0x62;
+        buff[2] = (unsigned char)rand();
+        buff[3] = (unsigned char)rand();
+        buff[4] = (unsigned char)len;
+        buff[5] = (unsigned char)(len >> 8);
+        return 6;
+    case 1:
+        len = rand() % 1024;
+        buff[0] = RTCM3PREAMB;
+        buff[1] = (unsigned char)(len >> 8);
+        buff[2] = (unsigned char)len;
+        return 3;
+    }
+    buff[0] = '$';
+    buff[1] = 'G';
+    return 2;
+}
+/* run demux over stream in blocks (blk: block length, 0: random) ------------*/
+static void run(run_t *r, const unsigned char *buff, int nbyte, int blk)
+{
+    int i, n;
+
+    cur = r;
+    init_demux(&r->dmx, NULL);
+    r->dmx.func = dmxfunc;
+    for (i = 0; i < nbyte; i += n)
+    {
+        n = blk ? blk : rand() % 512 + 1;
+        if (n > nbyte - i)
+            n = nbyte - i;
+        input_demux(&r->dmx, buff + i, n);
+    }
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    static const char *name[] = {"1-byte", "random", "whole"};
+    static run_t runs[NRUN];
+    unsigned char *buff;
+    int i, j, k, n = 20000, seed = 1, nbyte = 0, len, ngood = 0, nerr = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            n = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            seed = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: dmxtest [-n num] [-s seed]\n");
+            return 1;
+        }
+    }
+    if (n < 1 || !(buff = (unsigned char *)malloc((size_t)n * (MAXGAP + MAXPAY + 8))))
+    {
+        fprintf(stderr, "memory allocation error\n");
+        return 1;
+    }
+    srand(seed);
+
+    /* frames between gaps of random bytes */
+    for (i = 0; i < n; i++)
+    {
+        for (j = rand() % (MAXGAP + 1); j > 0; j--)
+            buff[nbyte++] = (unsigned char)rand();
+
+        switch (rand() % 8)
+        {
+        case 0:
+            nbyte += genfalse(buff + nbyte);
+            continue;
+        case 1:
+        case 2:
+            len = gennmea(buff + nbyte);
+            break;
+        case 3:
+        case 4:
+            len = genrtcm3(buff + nbyte);
+            break;
+        default:
+            len = genubx(buff + nbyte);
+            break;
+        }
+        switch (rand() % 8)
+        {
+        case 0: /* flipped byte */
+            buff[nbyte + rand() % len] ^= (unsigned char)(rand() % 255 + 1);
+            break;
+        case 1: /* truncated frame */
+            len = rand() % len + 1;
+            break;
+        default:
+            ngood++;
+            break;
+        }
+        nbyte += len;
+    }
+    run(runs, buff, nbyte, 1);
+    run(runs + 1, buff, nbyte, 0);
+    run(runs + 2, buff, nbyte, nbyte);
+
+    printf("stream : %12d bytes %8d frames %8d intact\n", nbyte, n, ngood);
+    for (k = 0; k < NRUN; k++)
+    {
+        printf("%-6s : %12u valid %8u ubx %8u nmea %8u rtcm3 %8u errors %8u skip\n",
+               name[k], runs[k].nfrm, runs[k].dmx.nframe[DMX_UBX],
+               runs[k].dmx.nframe[DMX_NMEA], runs[k].dmx.nframe[DMX_RTCM3],
+               runs[k].dmx.nerr[DMX_UBX] + runs[k].dmx.nerr[DMX_NMEA] +
+                   runs[k].dmx.nerr[DMX_RTCM3],
+               runs[k].dmx.nskip);
+        if (runs[k].nfrm != runs[2].nfrm || runs[k].hash != runs[2].hash ||
+            runs[k].dmx.nskip != runs[2].dmx.nskip ||
+            memcmp(runs[k].dmx.nerr, runs[2].dmx.nerr, sizeof(runs[k].dmx.nerr)))
+        {
+            fprintf(stderr, "%s blocks: frames differ from whole stream\n", name[k]);
+            nerr++;
+        }
+    }
+    if (runs[2].nfrm < (unsigned int)ngood)
+    {
+        fprintf(stderr, "whole stream: %u valid frames (%d intact)\n", runs[2].nfrm, ngood);
+        nerr++;
+    }
+    if (nerr)
+    {
+        printf("test failed: %d errors\n", nerr);
+        return 1;
+    }
+    printf("test ok\n");
+    return 0;
+}
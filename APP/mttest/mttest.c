@@ -0,0 +1,263 @@
+/*------------------------------------------------------------------------------
+ * mttest.c : multi-instance pipeline test (host)
+ *
+ * description : run several receiver pipelines (demux -> ubx decode -> rtkpos
+ *               -> nmea output) concurrently in one process, one thread per
+ *               pipeline, over a recorded ubx log, and compare the nmea output
+ *               of each pipeline with the output of a single-instance run.
+ *               each pipeline has its own raw_t, rtk_t, demux_t and held
+ *               course of outnmea_rmc(), so any state shared between the
+ *               instances by the decoders, the solver or the output functions
+ *               shows as a difference of the output.
+ *               the pipelines read the log in blocks in lockstep rounds
+ *               (barrier per round) and pipeline k starts k rounds late, so
+ *               the threads interleave at block level even on a single cpu
+ *               and process different parts of the log at the same time.
+ *               the processing options are the board defaults (as rtkrcv).
+ *               use a log with solutions (ephemerides and observation data)
+ *               to cover the solver and the nmea output.
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o mttest mttest.c ../../RTKLIB/demux.c
+ *              ../../RTKLIB/ublox.c ../../RTKLIB/rcvraw.c ../../RTKLIB/rtkcmn.c
+ *              ../../RTKLIB/sbas.c ../../RTKLIB/rtkpos.c ../../RTKLIB/pntpos.c
+ *              ../../RTKLIB/ephemeris.c ../../RTKLIB/ppp.c
+ *              ../../RTKLIB/solution.c ../../RTKLIB/geoid.c -lm -lpthread
+ *
+ * usage  : mttest [-n num] [-o file] file
+ *          -n num      number of concurrent pipelines (default 64)
+ *          -o file     write nmea output of single-instance run to file
+ *          file        ubx log file
+ *
+ *          exit status 0: ok, 1: output differs or error
+ *
+ *-----------------------------------------------------------------------------*/
+#include <pthread.h>
+#include "rtklib.h"
+
+#define MAXINST 256  /* max number of pipelines */
+#define NREAD 1024   /* input block length (bytes) */
+
+typedef struct
+{                          /* pipeline type */
+    raw_t raw;             /* receiver raw data control (first member) */
+    rtk_t rtk;             /* rtk control/result */
+    demux_t dmx;           /* stream demultiplexer */
+    int index;             /* pipeline index (start round) (-1: no lockstep) */
+    double dirp;           /* held course of rmc output (deg) */
+    unsigned char *out;    /* nmea output */
+    int nout, nmax;        /* output length/buffer size (bytes) */
+    int nepoch, nsol;      /* number of epochs/solutions */
+    int err;               /* memory allocation error */
+} inst_t;
+
+static prcopt_t opt;          /* processing options */
+static unsigned char *buff;   /* ubx log */
+static int nbuff;             /* ubx log length (bytes) */
+static int nround;            /* number of lockstep rounds */
+static pthread_barrier_t barrier; /* round barrier */
+
+/* append output to pipeline -------------------------------------------------*/
+static void addout(inst_t *inst, const unsigned char *p, int n)
+{
+    unsigned char *q;
+
+    if (inst->nout + n > inst->nmax)
+    {
+        if (!(q = (unsigned char *)realloc(inst->out, inst->nmax * 2 + n)))
+        {
+            inst->err = 1;
+            return;
+        }
+        inst->out = q;
+        inst->nmax = inst->nmax * 2 + n;
+    }
+    memcpy(inst->out + inst->nout, p, n);
+    inst->nout += n;
+}
+/* raw decode callback: solve epoch and output nmea (as solve() of board) ----*/
+static void rawfunc(raw_t *raw, int stat)
+{
+    inst_t *inst = (inst_t *)raw;
+    unsigned char rec[MAXOUTREC], *p;
+    rawevt_t evt;
+
+    (void)stat;
+    while (get_rawevt(raw, &evt))
+    {
+        if (evt.type != EVT_OBS)
+            continue;
+        rtkpos(&inst->rtk, raw->obs.data, raw->obs.n, &raw->nav);
+        inst->nepoch++;
+        if (inst->rtk.sol.stat != SOLQ_NONE)
+            inst->nsol++;
+        p = rec;
+        p += outnmea_gga(p, &inst->rtk.sol);
+        p += outnmea_rmc(p, &inst->rtk.sol, &inst->dirp);
+        addout(inst, rec, (int)(p - rec));
+    }
+}
+/* run pipeline over ubx log -------------------------------------------------*/
+static void *run(void *arg)
+{
+    inst_t *inst = (inst_t *)arg;
+    int i, r, n;
+
+    rtkinit(&inst->rtk, &opt);
+    init_raw(&inst->raw);
+    init_demux(&inst->dmx, &inst->raw);
+    inst->dmx.rawfunc = rawfunc;
+
+    if (inst->index < 0)
+    {
+        for (i = 0; i < nbuff; i += n)
+        {
+            n = nbuff - i < NREAD ? nbuff - i : NREAD;
+            input_demux(&inst->dmx, buff + i, n);
+        }
+        return NULL;
+    }
+    for (r = 0; r < nround; r++)
+    {
+        i = (r - inst->index) * NREAD;
+        if (0 <= i && i < nbuff)
+        {
+            n = nbuff - i < NREAD ? nbuff - i : NREAD;
+            input_demux(&inst->dmx, buff + i, n);
+        }
+        pthread_barrier_wait(&barrier);
+    }
+    return NULL;
+}
+/* read ubx log --------------------------------------------------------------*/
+static int readlog(const char *file)
+{
+    FILE *fp;
+    long size;
+
+    if (!(fp = fopen(file, "rb")))
+    {
+        fprintf(stderr, "file open error: %s\n", file);
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    rewind(fp);
+    if (size <= 0 || !(buff = (unsigned char *)malloc(size)) ||
+        fread(buff, 1, size, fp) != (size_t)size)
+    {
+        fprintf(stderr, "file read error: %s\n", file);
+        fclose(fp);
+        return 0;
+    }
+    nbuff = (int)size;
+    fclose(fp);
+    return 1;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    const double snrmask[] = {40.0, 35.0, 30.0, 25.0, 20.0, 20.0, 20.0, 20.0, 20.0};
+    const char *file = NULL, *outfile = NULL;
+    pthread_t thread[MAXINST];
+    inst_t *inst;
+    FILE *fp;
+    int i, j, n = 64, nbad = 0, nerr = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            n = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            outfile = argv[++i];
+        else if (argv[i][0] != '-' && !file)
+            file = argv[i];
+        else
+        {
+            file = NULL;
+            break;
+        }
+    }
+    if (!file || n < 1 || n > MAXINST)
+    {
+        fprintf(stderr, "usage: mttest [-n num] [-o file] file\n");
+        return 1;
+    }
+    if (!readlog(file))
+        return 1;
+
+    /* board default options (USER/main.c) */
+    memset(&opt, 0, sizeof(opt));
+    opt.mode = PMODE_SINGLE;
+    opt.nf = 1;
+    opt.navsys = SYS_GPS | SYS_CMP;
+    opt.elmin = 15.0 * D2R;
+    opt.snrmask.ena[0] = opt.snrmask.ena[1] = 1;
+    memcpy(opt.snrmask.mask[0], snrmask, sizeof(snrmask));
+    opt.ionoopt = IONOOPT_BRDC;
+    opt.tropopt = TROPOPT_SAAS;
+    opt.niter = 1;
+    opt.eratio = 100.0;
+    opt.err[0] = 100.0;
+    opt.err[1] = opt.err[2] = 0.003;
+    opt.err[4] = 1.0;
+    opt.maxgdop = 30.0;
+    opt.posopt[4] = 1;
+
+    if (!(inst = (inst_t *)calloc(n + 1, sizeof(inst_t))))
+    {
+        fprintf(stderr, "memory allocation error\n");
+        return 1;
+    }
+    /* single-instance run (reference) */
+    inst[n].index = -1;
+    run(inst + n);
+
+    nround = (nbuff + NREAD - 1) / NREAD + n - 1;
+    pthread_barrier_init(&barrier, NULL, n);
+    for (i = 0; i < n; i++)
+    {
+        inst[i].index = i;
+        if (pthread_create(thread + i, NULL, run, inst + i))
+        {
+            fprintf(stderr, "thread create error\n");
+            return 1;
+        }
+    }
+    for (i = 0; i < n; i++)
+        pthread_join(thread[i], NULL);
+    pthread_barrier_destroy(&barrier);
+
+    for (i = 0; i <= n; i++)
+        nerr += inst[i].err;
+
+    for (i = 0; i < n; i++)
+    {
+        if (inst[i].nout == inst[n].nout && inst[i].nepoch == inst[n].nepoch &&
+            !memcmp(inst[i].out, inst[n].out, inst[n].nout))
+            continue;
+        for (j = 0; j < inst[i].nout && j < inst[n].nout; j++)
+        {
+            if (inst[i].out[j] != inst[n].out[j])
+                break;
+        }
+        if (nbad++ < 10)
+            fprintf(stderr, "pipeline %2d: output differs at byte %d\n", i, j);
+    }
+    if (outfile && (fp = fopen(outfile, "wb")))
+    {
+        fwrite(inst[n].out, 1, inst[n].nout, fp);
+        fclose(fp);
+    }
+    printf("input  : %12d bytes %8d pipelines\n", nbuff, n);
+    printf("epochs : %12d (%d solutions)\n", inst[n].nepoch, inst[n].nsol);
+    printf("output : %12d bytes\n", inst[n].nout);
+    printf("differ : %12d pipelines\n", nbad);
+
+    if (nbad || nerr)
+    {
+        printf("test failed: %s\n", nerr ? "memory allocation error" : "output differs");
+        return 1;
+    }
+    printf("test ok\n");
+    return 0;
+}
@@ -0,0 +1,162 @@
+/*------------------------------------------------------------------------------
+ * ringtest.c : two-thread test of byte ring (host)
+ *
+ * description : run one producer thread (as the uart receive interrupt) and
+ *               one consumer thread (as the processing loop) on a byte ring of
+ *               ring.c. the producer writes a pseudo-random byte sequence in
+ *               blocks of random length (1 byte by put_ring(), longer blocks
+ *               by write_ring()) paced to the data rate and never waits for
+ *               the consumer, so a slow consumer shows as dropped bytes. the
+ *               consumer reads the bytes in place by peek_ring()/skip_ring()
+ *               and checks them against the same sequence.
+ *               the test fails on a byte out of order, on a dropped byte
+ *               (nlost, novf) or on a high-water mark out of range (below
+ *               the fill level seen by the consumer or above the ring size).
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o ringtest ringtest.c ../../RTKLIB/ring.c
+ *              ../../RTKLIB/rtkcmn.c -lm -lpthread
+ *
+ * usage  : ringtest [-r rate] [-n size] [-s size]
+ *          -r rate     data rate (MB/s) (default 4, 0: no pacing)
+ *          -n size     data size (MB) (default 64)
+ *          -s size     ring size (bytes) (power of 2) (default 65536)
+ *
+ *          exit status 0: ok, 1: test failed
+ *
+ *-----------------------------------------------------------------------------*/
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "rtklib.h"
+
+#define MAXBLK 256 /* max block length of producer (bytes) */
+
+static ring_t ring;
+static double rate = 4.0;        /* data rate (MB/s) */
+static unsigned int nbyte;       /* data size (bytes) */
+static volatile int done;        /* producer done */
+
+/* current time (s) ----------------------------------------------------------*/
+static double tickd(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+/* test byte sequence (xorshift32) -------------------------------------------*/
+static unsigned int nextseq(unsigned int *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+/* producer thread -----------------------------------------------------------*/
+static void *producer(void *arg)
+{
+    static const struct timespec ts = {0, 100000};
+    unsigned char buff[MAXBLK];
+    unsigned int sd = 0x12345678, sl = 0x9E3779B9, i, n, nw = 0;
+    double t0 = tickd();
+
+    (void)arg;
+    while (nw < nbyte)
+    {
+        n = nextseq(&sl) % MAXBLK + 1;
+        if (n > nbyte - nw)
+            n = nbyte - nw;
+        for (i = 0; i < n; i++)
+            buff[i] = (unsigned char)nextseq(&sd);
+        if (n == 1)
+            put_ring(&ring, buff[0]);
+        else
+            write_ring(&ring, buff, (int)n);
+        nw += n;
+
+        /* pace to data rate */
+        while (rate > 0.0 && nw > (tickd() - t0) * rate * 1E6)
+            nanosleep(&ts, NULL);
+    }
+    done = 1;
+    return NULL;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    static unsigned char buff[1 << 24];
+    const unsigned char *p;
+    pthread_t thread;
+    unsigned int size = 65536, sd = 0x12345678, nr = 0, nerr = 0, used, maxused = 0;
+    double t;
+    int i, n;
+
+    nbyte = 64u << 20;
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            rate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            nbyte = (unsigned int)(atof(argv[++i]) * 1048576.0);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            size = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: ringtest [-r rate] [-n size] [-s size]\n");
+            return 1;
+        }
+    }
+    if (size > sizeof(buff) || !init_ring(&ring, buff, size))
+    {
+        fprintf(stderr, "ring size error: %u\n", size);
+        return 1;
+    }
+    t = tickd();
+    if (pthread_create(&thread, NULL, producer, NULL))
+    {
+        fprintf(stderr, "thread create error\n");
+        return 1;
+    }
+    /* consumer */
+    for (;;)
+    {
+        used = ring.head - ring.tail;
+        if (used > maxused)
+            maxused = used;
+
+        if ((n = peek_ring(&ring, &p)) <= 0)
+        {
+            if (done && ring.head == ring.tail)
+                break;
+            sched_yield();
+            continue;
+        }
+        for (i = 0; i < n; i++)
+        {
+            if (p[i] != (unsigned char)nextseq(&sd) && nerr++ == 0)
+                fprintf(stderr, "order error: byte %u\n", nr + i);
+        }
+        skip_ring(&ring, n);
+        nr += n;
+    }
+    pthread_join(thread, NULL);
+    t = tickd() - t;
+
+    printf("bytes  : %12u read %12u lost %8u ovf\n", nr, ring.nlost, ring.novf);
+    printf("rate   : %12.2f MB/s %10.3f s\n", nr / t / 1E6, t);
+    printf("hwm    : %12u bytes %10u max fill %8u size\n", ring.hwm, maxused, size);
+    printf("errors : %12u\n", nerr);
+
+    if (nerr || ring.nlost || ring.novf || nr != nbyte)
+    {
+        printf("test failed: ordering or dropped bytes\n");
+        return 1;
+    }
+    if (ring.hwm < maxused || ring.hwm > size || (nbyte && !ring.hwm))
+    {
+        printf("test failed: high-water mark\n");
+        return 1;
+    }
+    printf("test ok\n");
+    return 0;
+}
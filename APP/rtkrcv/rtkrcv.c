@@ -0,0 +1,266 @@
+/*------------------------------------------------------------------------------
+ * rtkrcv.c : receiver stream pipeline (host)
+ *
+ * description : run the pipeline of the board (stream -> demux -> ubx decode
+ *               -> rtkpos -> nmea output) on linux with any stream transport
+ *               of stream.c, so the byte streams the board sees (serial port,
+ *               pty, tcp or recorded file) are processed and benchmarked on
+ *               the host. the processing options are the board defaults.
+ *               the nmea output is formatted into records of an output queue
+ *               and written by a writer thread (as the uart transmit interrupt
+ *               of the board), so a slow output stream drops the oldest
+ *               records instead of delaying the solutions.
+ *               the latencies arrival->decode->solution of the observation
+ *               data and solution->output (record committed to written) are
+ *               reported. the arrival is the read time of the stream.
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o rtkrcv rtkrcv.c ../../RTKLIB/stream.c
+ *              ../../RTKLIB/demux.c ../../RTKLIB/ublox.c ../../RTKLIB/rcvraw.c
+ *              ../../RTKLIB/rtkcmn.c ../../RTKLIB/sbas.c ../../RTKLIB/rtkpos.c
+ *              ../../RTKLIB/pntpos.c ../../RTKLIB/ephemeris.c ../../RTKLIB/ppp.c
+ *              ../../RTKLIB/solution.c ../../RTKLIB/geoid.c
+ *              ../../RTKLIB/ring.c -lm -lpthread
+ *
+ * usage  : rtkrcv [-in stream] [-out stream] [-t sec]
+ *          -in stream  input stream (default file://-)
+ *          -out stream nmea output stream (default none)
+ *          -t sec      stop after sec seconds (default: end of input)
+ *
+ *          stream: serial://port[:brate]  pty://[link]  tcpsvr://:port
+ *                  tcpcli://addr:port     file://path   (path "-": stdin/stdout)
+ *
+ *          rtkrcv -in serial://ttyACM0:115200 -out tcpsvr://:2101
+ *          rtkrcv -in file://log.ubx -out file://out.nmea
+ *
+ *-----------------------------------------------------------------------------*/
+#include <time.h>
+#include <pthread.h>
+#include "rtklib.h"
+
+static strsvr_t svr;        /* stream server (too large for stack) */
+static demux_t dmx;         /* stream demultiplexer */
+static outq_t outq;         /* nmea output record queue */
+static volatile int outend; /* end of output (writer stops when queue empty) */
+static double tsolve;       /* solve time (s) */
+static double lat[3][2];    /* latency arrival-decode,decode-solution,arrival-solution {sum,max} (s) */
+static int nepoch, nsol;
+static int niter, nitermax; /* spp iterations of solutions {sum,max} */
+
+/* current time (s) ----------------------------------------------------------*/
+static double tickd(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+/* open stream by url (type://path) ------------------------------------------*/
+static int openurl(stream_t *stream, const char *url, int mode)
+{
+    const char *type[] = {"serial", "pty", "tcpsvr", "tcpcli", "file"};
+    const int stype[] = {STR_SERIAL, STR_PTY, STR_TCPSVR, STR_TCPCLI, STR_FILE};
+    const char *p;
+    int i;
+
+    if (!(p = strstr(url, "://")))
+    {
+        fprintf(stderr, "stream error: %s\n", url);
+        return 0;
+    }
+    for (i = 0; i < 5; i++)
+    {
+        if (strlen(type[i]) == (size_t)(p - url) && !strncmp(url, type[i], p - url))
+            break;
+    }
+    if (i >= 5 || !stropen(stream, stype[i], mode, p + 3))
+    {
+        fprintf(stderr, "stream open error: %s %s\n", url, i < 5 ? stream->msg : "");
+        return 0;
+    }
+    if (stype[i] == STR_PTY)
+        fprintf(stderr, "pty: %s\n", stream->msg);
+    return 1;
+}
+/* sleep ms ------------------------------------------------------------------*/
+static void sleepms(int ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = ms % 1000 * 1000000L;
+    nanosleep(&ts, NULL);
+}
+/* output writer thread: write output records to output stream ---------------*/
+static void *writer(void *arg)
+{
+    const unsigned char *p;
+    int n, nw = 0, nstall = 0;
+
+    (void)arg;
+    while (svr.stream[1].state > 0)
+    {
+        if ((n = peek_outq(&outq, &p)) > 0 && (nw = strwrite(&svr.stream[1], p, n)) > 0)
+        {
+            skip_outq(&outq, nw);
+            nstall = 0;
+            continue;
+        }
+        if (outend && (n <= 0 || ++nstall > 1000)) /* queue empty or stalled 1 s */
+            break;
+        sleepms(1);
+    }
+    return NULL;
+}
+/* add latency to statistics -------------------------------------------------*/
+static void addlat(double *stat, unsigned int tick)
+{
+    double t = tick / TICKFREQ;
+
+    stat[0] += t;
+    if (t > stat[1])
+        stat[1] = t;
+}
+/* solve epoch and output nmea (as solve() of the board) ---------------------*/
+static void solve(const rawevt_t *evt)
+{
+    unsigned char *rec, *p;
+    unsigned int tsol;
+    double t = tickd();
+
+    rtkpos(&svr.rtk, svr.raw[0].obs.data, svr.raw[0].obs.n, &svr.raw[0].nav);
+    tsol = tickcnt();
+    svr.rtk.sol.processTime = (int)((tsol - evt->tarr) / TICKFREQ * 1E6);
+    addlat(lat[0], evt->tdec - evt->tarr);
+    addlat(lat[1], tsol - evt->tdec);
+    addlat(lat[2], tsol - evt->tarr);
+    nepoch++;
+    if (svr.rtk.sol.stat != SOLQ_NONE)
+    {
+        nsol++;
+        niter += svr.rtk.sol.niter;
+        if (svr.rtk.sol.niter > nitermax)
+            nitermax = svr.rtk.sol.niter;
+    }
+
+    if (svr.stream[1].state > 0)
+    {
+        rec = p = alloc_outq(&outq);
+        p += outnmea_gga(p, &svr.rtk.sol);
+        p += outnmea_rmc(p, &svr.rtk.sol, &svr.dirp);
+        commit_outq(&outq, p - rec);
+    }
+    tsolve += tickd() - t;
+}
+/* raw decode callback: drain raw events -------------------------------------*/
+static void rawfunc(raw_t *raw, int stat)
+{
+    rawevt_t evt;
+
+    (void)stat;
+    while (get_rawevt(raw, &evt))
+    {
+        if (evt.type == EVT_OBS)
+            solve(&evt);
+    }
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    static unsigned char buff[4096];
+    const char *in = "file://-", *out = NULL;
+    const double snrmask[] = {40.0, 35.0, 30.0, 25.0, 20.0, 20.0, 20.0, 20.0, 20.0};
+    prcopt_t opt;
+    pthread_t thread;
+    double t, tout = 0.0;
+    int i, n;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-in") && i + 1 < argc)
+            in = argv[++i];
+        else if (!strcmp(argv[i], "-out") && i + 1 < argc)
+            out = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+            tout = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: rtkrcv [-in stream] [-out stream] [-t sec]\n");
+            return -1;
+        }
+    }
+    /* board default options (USER/main.c) */
+    memset(&opt, 0, sizeof(opt));
+    opt.mode = PMODE_SINGLE;
+    opt.nf = 1;
+    opt.navsys = SYS_GPS | SYS_CMP;
+    opt.elmin = 15.0 * D2R;
+    opt.snrmask.ena[0] = opt.snrmask.ena[1] = 1;
+    memcpy(opt.snrmask.mask[0], snrmask, sizeof(snrmask));
+    opt.ionoopt = IONOOPT_BRDC;
+    opt.tropopt = TROPOPT_SAAS;
+    opt.niter = 1;
+    opt.eratio = 100.0;
+    opt.err[0] = 100.0;
+    opt.err[1] = opt.err[2] = 0.003;
+    opt.err[4] = 1.0;
+    opt.maxgdop = 30.0;
+    opt.posopt[4] = 1;
+
+    if (!openurl(&svr.stream[0], in, STR_MODE_RW) ||
+        (out && !openurl(&svr.stream[1], out, STR_MODE_W)))
+        return -1;
+
+    rtkinit(&svr.rtk, &opt);
+    init_raw(&svr.raw[0]);
+    init_demux(&dmx, &svr.raw[0]);
+    dmx.rawfunc = rawfunc;
+
+    init_outq(&outq);
+    if (svr.stream[1].state > 0 && pthread_create(&thread, NULL, writer, NULL))
+    {
+        fprintf(stderr, "writer thread error\n");
+        return -1;
+    }
+    t = tickd();
+    while (svr.stream[0].state > 0 && (tout <= 0.0 || tickd() - t < tout))
+    {
+        if ((n = strread(&svr.stream[0], buff, sizeof(buff))) > 0)
+        {
+            svr.raw[0].tarr = svr.stream[0].tarr;
+            input_demux(&dmx, buff, n);
+        }
+        else
+            strpoll(&svr.stream[0], 100);
+    }
+    if (svr.stream[1].state > 0)
+    {
+        outend = 1;
+        pthread_join(thread, NULL);
+    }
+    t = tickd() - t;
+    if (t <= 0.0)
+        t = 1E-9;
+
+    fprintf(stderr, "input  : %12u bytes (%8.3f MB/s) %s\n", svr.stream[0].inb,
+            svr.stream[0].inb / t * 1E-6, svr.stream[0].msg);
+    fprintf(stderr, "epochs : %12d (%8.0f epochs/s, %d solutions)\n", nepoch,
+            nepoch / t, nsol);
+    fprintf(stderr, "solve  : %12.3f ms/epoch\n", nepoch > 0 ? tsolve / nepoch * 1E3 : 0.0);
+    fprintf(stderr, "iter   : %12.2f mean %8d max\n", nsol > 0 ? (double)niter / nsol : 0.0,
+            nitermax);
+    fprintf(stderr, "output : %12u bytes (%u records, %u dropped)\n",
+            svr.stream[1].outb, outq.nrec, outq.nrec - outq.nsent);
+    fprintf(stderr, "events : %12u lost\n", svr.raw[0].nevtlost);
+    for (i = 0; i < 3; i++)
+    {
+        fprintf(stderr, "%s: %12.3f ms mean %8.3f ms max\n",
+                i == 0 ? "arr-dec" : (i == 1 ? "dec-sol" : "arr-sol"),
+                nepoch > 0 ? lat[i][0] / nepoch * 1E3 : 0.0, lat[i][1] * 1E3);
+    }
+    fprintf(stderr, "sol-out: %12.3f ms last %8.3f ms max\n", outq.tout / TICKFREQ * 1E3,
+            outq.toutmax / TICKFREQ * 1E3);
+
+    strclose(&svr.stream[0]);
+    strclose(&svr.stream[1]);
+    return 0;
+}
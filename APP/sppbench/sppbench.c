@@ -0,0 +1,366 @@
+/*------------------------------------------------------------------------------
+ * sppbench.c : single point positioning benchmark (host)
+ *
+ * description : generate synthetic epochs of a known receiver track (vehicle
+ *               moving east at 15 m/s, clock bias drifting) and broadcast
+ *               ephemerides (gps, galileo, beidou, qzss constellations), and
+ *               solve them by pntpos() with the board default options.
+ *               the pseudoranges include broadcast ionosphere, troposphere,
+ *               inter-system bias and gaussian noise, the doppler includes
+ *               the satellite and receiver clock drift.
+ *               with -snr, the snr falls with the elevation (28+22*sin(el)
+ *               dBHz) and the code noise of satellites below 36 dBHz is
+ *               raised, so the low satellites are rejected by the snr mask.
+ *               the time of pntpos() per epoch (best of repeated calls) and
+ *               the position error to the track are reported.
+ *               with -f, a pseudorange fault is added to one satellite every
+ *               FAULTINT epochs and the exclusion of the faulty satellite by
+ *               raim fde is counted (from ssat[].vs).
+ *               with -o, the solutions are written to a file, and with -c,
+ *               the solutions are compared with such a file, so builds of
+ *               the solver (e.g. before and after a change) are compared on
+ *               the same epochs.
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o sppbench sppbench.c ../../RTKLIB/pntpos.c
+ *              ../../RTKLIB/ephemeris.c ../../RTKLIB/rtkcmn.c
+ *              ../../RTKLIB/sbas.c -lm
+ *
+ * usage  : sppbench [-n num] [-d sec] [-sys sys] [-e deg] [-f bias] [-snr]
+ *                   [-r num] [-s seed] [-o file] [-c file]
+ *          -n num      number of epochs (default 3600)
+ *          -d sec      epoch interval (s) (default 1)
+ *          -sys sys    navigation systems G:gps,E:galileo,C:beidou,J:qzss
+ *                      (default GC)
+ *          -e deg      elevation mask (deg) (default 15)
+ *          -f bias     pseudorange fault (m) (default 0: no fault)
+ *          -snr        elevation dependent snr (default 45 dBHz)
+ *          -r num      pntpos() calls per epoch for timing (default 3)
+ *          -s seed     random seed of noise (default 1)
+ *          -o file     write solutions to file
+ *          -c file     compare solutions with file written by -o
+ *
+ *-----------------------------------------------------------------------------*/
+#include <time.h>
+#include "rtklib.h"
+
+#define SQR(x) ((x) * (x))
+#define SIGCODE 0.5 /* code noise (m) */
+#define SIGDOP 0.05 /* doppler noise (m/s) */
+#define SIGLOW 5.0  /* code noise of low snr satellites (m) */
+#define FAULTINT 10 /* fault interval (epochs) */
+#define FAULTOBS 3  /* observation index of faulty satellite */
+
+static nav_t nav;        /* broadcast ephemerides (too large for stack) */
+static ssat_t ssat[MAXSAT]; /* satellite status */
+
+/* current time (s) ----------------------------------------------------------*/
+static double tickd(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+}
+/* gaussian random number ----------------------------------------------------*/
+static double gauss(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * PI * v);
+}
+/* add broadcast ephemeris of circular-like orbit ----------------------------*/
+static void addeph(int sat, double A, double inc, double OMG0, double M0,
+                   gtime_t toe)
+{
+    eph_t *eph = nav.eph + nav.n++;
+    int week;
+
+    memset(eph, 0, sizeof(eph_t));
+    eph->sat = sat;
+    eph->A = A;
+    eph->e = 0.004 + 0.0003 * (sat % 7);
+    eph->i0 = inc;
+    eph->OMG0 = OMG0;
+    eph->M0 = M0;
+    eph->omg = 0.3 * (sat % 5);
+    eph->OMGd = -8E-9;
+    eph->toe = eph->toc = eph->ttr = toe;
+    eph->toes = time2gpst(toe, &week);
+    eph->week = week;
+    eph->f0 = 1E-5 * ((sat % 9) - 4);
+    eph->f1 = 1E-12;
+    eph->iode = 1;
+}
+/* generate broadcast ephemerides --------------------------------------------*/
+static void simnav(gtime_t toe)
+{
+    int i;
+
+    memset(&nav, 0, sizeof(nav_t));
+    for (i = 0; i < 31; i++)
+        addeph(satno(SYS_GPS, i + 1), 26559710.0, 55.0 * D2R, (i % 6) * 60.0 * D2R,
+               ((i / 6) * 60.0 + (i % 6) * 15.0) * D2R, toe);
+    for (i = 0; i < 30; i++)
+        addeph(satno(SYS_CMP, i + 6), 27906100.0, 55.0 * D2R, (i % 3) * 120.0 * D2R + 0.4,
+               (i / 3) * 36.0 * D2R + (i % 3) * 0.25, toe);
+    for (i = 0; i < 27; i++)
+        addeph(satno(SYS_GAL, i + 1), 29600000.0, 56.0 * D2R, (i % 3) * 120.0 * D2R + 1.1,
+               (i / 3) * 40.0 * D2R + (i % 3) * 0.15, toe);
+    for (i = 0; i < 5; i++)
+        addeph(satno(SYS_QZS, i + 193), 42164000.0, 41.0 * D2R, (i * 72.0 + 200.0) * D2R,
+               i * 144.0 * D2R, toe);
+    for (i = 0; i < MAXSAT; i++)
+    {
+        nav.lam[i][0] = CLIGHT / FREQ1;
+        nav.lam[i][1] = CLIGHT / FREQ2;
+        nav.lam[i][2] = CLIGHT / FREQ5;
+    }
+}
+/* receiver track at t (s): position/velocity (ecef) and clock bias/drift ----*/
+static void simrcv(double t, double *rr, double *dtr)
+{
+    const double pos[] = {30.5 * D2R, 114.3 * D2R, 30.0};
+    double E[9], enu[3], dr[3];
+    int i;
+
+    pos2ecef(pos, rr);
+    xyz2enu(pos, E);
+    enu[0] = 15.0 * t;
+    enu[1] = 2.0 * t;
+    enu[2] = 0.0;
+    matmul("TN", 3, 1, 3, 1.0, E, enu, 0.0, dr);
+    for (i = 0; i < 3; i++)
+        rr[i] += dr[i];
+    enu[0] = 15.0;
+    enu[1] = 2.0;
+    matmul("TN", 3, 1, 3, 1.0, E, enu, 0.0, rr + 3);
+    dtr[0] = 1E-4 + 1E-8 * t;
+    dtr[1] = 1E-8;
+}
+/* generate observation data at t (s) ----------------------------------------*/
+static int simobs(gtime_t t0, double t, double elmask, int navsys, int snrel,
+                  obsd_t *obs)
+{
+    const double isb[] = {0.0, 3.0, 5.0}; /* inter-system bias gps,gal,bds (m) */
+    double rr[6], dtr[2], pos[3], rs[6], dts[2], var, e[3], azel[2], P, rate, snr;
+    gtime_t time;
+    int i, j, n = 0, svh, sys;
+
+    simrcv(t, rr, dtr);
+    ecef2pos(rr, pos);
+    time = timeadd(t0, t + dtr[0]);
+
+    for (i = 0; i < nav.n && n < MAXOBS; i++)
+    {
+        if (!((sys = satsys(nav.eph[i].sat, NULL)) & navsys))
+            continue;
+        memset(obs + n, 0, sizeof(obsd_t));
+        obs[n].time = time;
+        obs[n].sat = nav.eph[i].sat;
+        obs[n].SNR[0] = obs[n].SNR[1] = 45 * 4;
+        obs[n].code[0] = CODE_L1C;
+
+        /* light time iteration */
+        for (P = 0.075 * CLIGHT, j = 0; j < 4; j++)
+        {
+            obs[n].P[0] = P;
+            satposs(time, obs + n, 1, &nav, EPHOPT_BRDC, rs, dts, &var, &svh);
+            P = geodist(rs, rr, e) + CLIGHT * (dtr[0] - dts[0]);
+        }
+        if (satazel(pos, e, azel) < elmask)
+            continue;
+        P += ionmodel(time, nav.ion_gps, pos, azel) * SQR(nav.lam[obs[n].sat - 1][0] / lam_carr[0]);
+        P += tropmodel(time, pos, azel, 0.7);
+        P += isb[sys == SYS_GAL ? 1 : (sys == SYS_CMP ? 2 : 0)] + SIGCODE * gauss();
+        if (snrel)
+        {
+            snr = 28.0 + 22.0 * sin(azel[1]);
+            obs[n].SNR[0] = obs[n].SNR[1] = (unsigned char)(snr * 4.0);
+            if (snr < 36.0)
+                P += SIGLOW * gauss();
+        }
+        obs[n].P[0] = P;
+
+        rate = (rs[3] - rr[3]) * e[0] + (rs[4] - rr[4]) * e[1] + (rs[5] - rr[5]) * e[2] +
+               OMGE / CLIGHT * (rs[4] * rr[0] + rs[1] * rr[3] - rs[3] * rr[1] - rs[0] * rr[4]);
+        obs[n].D[0] = (float)(-(rate + CLIGHT * (dtr[1] - dts[1]) + SIGDOP * gauss()) /
+                              nav.lam[obs[n].sat - 1][0]);
+        n++;
+    }
+    return n;
+}
+/* navigation systems string to navsys ---------------------------------------*/
+static int str2sys(const char *s)
+{
+    int sys = 0;
+
+    for (; *s; s++)
+    {
+        if (*s == 'G')
+            sys |= SYS_GPS;
+        else if (*s == 'E')
+            sys |= SYS_GAL;
+        else if (*s == 'C')
+            sys |= SYS_CMP;
+        else if (*s == 'J')
+            sys |= SYS_QZS;
+    }
+    return sys;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    const double snrmask[] = {40.0, 35.0, 30.0, 25.0, 20.0, 20.0, 20.0, 20.0, 20.0};
+    const double ep0[] = {2026, 10, 17, 4, 0, 0};
+    const char *outfile = NULL, *cmpfile = NULL;
+    obsd_t obs[MAXOBS];
+    prcopt_t opt;
+    sol_t sol, sol0;
+    gtime_t t0 = epoch2time(ep0);
+    FILE *fo = NULL, *fc = NULL;
+    char msg[128];
+    double dt = 1.0, elmask = 15.0, rr[6], dtr[2], t, tbest, tsum = 0.0, tmax = 0.0;
+    double err = 0.0, sr[6], dp, dv, dpmax = 0.0, dvmax = 0.0, bias = 0.0;
+    int i, j, k, n, stat = 0, nep = 3600, nrep = 3, seed = 1, navsys = SYS_GPS | SYS_CMP;
+    int nsol = 0, nsat = 0, ncmp = 0, ndiff = 0, cstat, cns, fault, nfault = 0, nexc = 0;
+    int snrel = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            nep = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+            dt = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-sys") && i + 1 < argc)
+            navsys = str2sys(argv[++i]);
+        else if (!strcmp(argv[i], "-e") && i + 1 < argc)
+            elmask = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc)
+            bias = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-snr"))
+            snrel = 1;
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            nrep = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            seed = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            outfile = argv[++i];
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+            cmpfile = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: sppbench [-n num] [-d sec] [-sys sys] [-e deg] [-f bias] "
+                            "[-snr] [-r num] [-s seed] [-o file] [-c file]\n");
+            return -1;
+        }
+    }
+    if (nep <= 0 || nrep <= 0 || !navsys)
+    {
+        fprintf(stderr, "option error: epochs %d calls %d systems %d\n", nep, nrep, navsys);
+        return -1;
+    }
+    if ((outfile && !(fo = fopen(outfile, "w"))) ||
+        (cmpfile && !(fc = fopen(cmpfile, "r"))))
+    {
+        fprintf(stderr, "file open error: %s\n", fo || !outfile ? cmpfile : outfile);
+        return -1;
+    }
+    /* board default options (USER/main.c) */
+    memset(&opt, 0, sizeof(opt));
+    opt.mode = PMODE_SINGLE;
+    opt.nf = 1;
+    opt.navsys = navsys;
+    opt.elmin = elmask * D2R;
+    opt.snrmask.ena[0] = opt.snrmask.ena[1] = 1;
+    memcpy(opt.snrmask.mask[0], snrmask, sizeof(snrmask));
+    opt.ionoopt = IONOOPT_BRDC;
+    opt.tropopt = TROPOPT_SAAS;
+    opt.niter = 1;
+    opt.eratio = 100.0;
+    opt.err[0] = 100.0;
+    opt.err[1] = opt.err[2] = 0.003;
+    opt.err[4] = 1.0;
+    opt.maxgdop = 30.0;
+    opt.posopt[4] = 1;
+
+    memset(&sol, 0, sizeof(sol));
+    srand(seed);
+    simnav(timeadd(t0, 1800.0));
+
+    for (k = 0; k < nep; k++)
+    {
+        /* observations down to 2 deg below mask */
+        n = simobs(t0, k * dt, elmask > 2.0 ? (elmask - 2.0) * D2R : 0.0, navsys, snrel, obs);
+        nsat += n;
+        if ((fault = bias != 0.0 && k % FAULTINT == FAULTINT / 2 && n > FAULTOBS) != 0)
+        {
+            obs[FAULTOBS].P[0] += bias;
+            nfault++;
+        }
+
+        /* best of repeated calls from same previous solution */
+        for (tbest = 1E9, j = 0; j < nrep; j++)
+        {
+            sol0 = sol;
+            t = tickd();
+            stat = pntpos(obs, n, &nav, &opt, &sol0, NULL, bias != 0.0 ? ssat : NULL, msg);
+            t = tickd() - t;
+            if (t < tbest)
+                tbest = t;
+        }
+        sol = sol0;
+        tsum += tbest;
+        if (tbest > tmax)
+            tmax = tbest;
+
+        if (fo)
+        {
+            fprintf(fo, "%d %d %.17g %.17g %.17g %.17g %.17g %.17g\n", stat, sol.ns, sol.rr[0],
+                    sol.rr[1], sol.rr[2], sol.rr[3], sol.rr[4], sol.rr[5]);
+        }
+        /* compare with solution of same epoch in file */
+        if (fc)
+        {
+            if (fscanf(fc, "%d %d %lf %lf %lf %lf %lf %lf", &cstat, &cns, sr, sr + 1,
+                       sr + 2, sr + 3, sr + 4, sr + 5) != 8)
+            {
+                fprintf(stderr, "compare file too short: epoch %d\n", k);
+                fclose(fc);
+                fc = NULL;
+            }
+            else if (cstat != stat || (stat && cns != sol.ns))
+                ndiff++;
+            else if (stat)
+            {
+                dp = sqrt(SQR(sol.rr[0] - sr[0]) + SQR(sol.rr[1] - sr[1]) + SQR(sol.rr[2] - sr[2]));
+                dv = sqrt(SQR(sol.rr[3] - sr[3]) + SQR(sol.rr[4] - sr[4]) + SQR(sol.rr[5] - sr[5]));
+                if (dp > dpmax)
+                    dpmax = dp;
+                if (dv > dvmax)
+                    dvmax = dv;
+                ncmp++;
+            }
+        }
+        if (!stat)
+            continue;
+        nsol++;
+        if (fault && !ssat[obs[FAULTOBS].sat - 1].vs)
+            nexc++;
+        simrcv(k * dt, rr, dtr);
+        err += sqrt(SQR(sol.rr[0] - rr[0]) + SQR(sol.rr[1] - rr[1]) + SQR(sol.rr[2] - rr[2]));
+    }
+    printf("epochs : %12d (%d solutions, %.1f sats)\n", nep, nsol, (double)nsat / nep);
+    printf("error  : %12.3f m (mean 3d)\n", nsol > 0 ? err / nsol : 0.0);
+    printf("pntpos : %12.2f us/epoch mean %8.1f us max\n", tsum / nep * 1E6, tmax * 1E6);
+    if (bias != 0.0)
+        printf("fault  : %12d epochs %8d faulty satellite excluded\n", nfault, nexc);
+    if (fc)
+    {
+        printf("compare: %12d solutions %8d epochs differ (status/sats)\n", ncmp, ndiff);
+        printf("diff   : %12.3e m pos max %8.3e m/s vel max\n", dpmax, dvmax);
+        fclose(fc);
+    }
+    if (fo)
+        fclose(fo);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*------------------------------------------------------------------------------
+ * sys.h : stm32f7 register model for host simulation of uart drivers
+ *
+ * description : replaces SYSTEM/sys/sys.h when HARDWARE/USART3/usart3.c is
+ *               built on the host by uartsim. the usart registers are plain
+ *               memory driven by the simulator; clock, gpio and nvic setup
+ *               are no-ops.
+ *
+ * history : 2026/10/17 1.0 new
+ *-----------------------------------------------------------------------------*/
+#ifndef __SYS_H
+#define __SYS_H
+#include <stdint.h>
+
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t u8;
+typedef volatile uint32_t vu32;
+typedef volatile uint16_t vu16;
+typedef volatile uint8_t vu8;
+
+#define __align(x) /* armcc alignment attribute */
+
+typedef struct
+{ /* usart registers (stm32f7) */
+    volatile u32 CR1, CR2, CR3, BRR, GTPR, RTOR, RQR, ISR, ICR, RDR, TDR;
+} USART_TypeDef;
+
+typedef struct
+{ /* rcc registers (clock enable only) */
+    volatile u32 AHB1ENR, APB1ENR, APB2ENR;
+} RCC_TypeDef;
+
+typedef struct
+{ /* gpio port (not modeled) */
+    volatile u32 MODER;
+} GPIO_TypeDef;
+
+extern USART_TypeDef sim_usart3;
+extern RCC_TypeDef sim_rcc;
+extern GPIO_TypeDef sim_gpio;
+
+#define USART3 (&sim_usart3)
+#define RCC (&sim_rcc)
+#define GPIOB (&sim_gpio)
+#define USART3_IRQn 39
+
+#define PIN10 (1 << 10)
+#define PIN11 (1 << 11)
+#define GPIO_MODE_AF 2
+#define GPIO_OTYPE_PP 0
+#define GPIO_SPEED_50M 2
+#define GPIO_PUPD_PU 1
+
+#define GPIO_Set(gpio, bits, mode, otype, ospeed, pupd)
+#define GPIO_AF_Set(gpio, bit, af)
+#define MY_NVIC_Init(pre, sub, ch, group)
+
+#endif
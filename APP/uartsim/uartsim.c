@@ -0,0 +1,331 @@
+/*------------------------------------------------------------------------------
+ * uartsim.c : host simulation of uart receive ingestion
+ *
+ * description : replay a ublox raw log through the receive driver of the
+ *               board (HARDWARE/USART3/usart3.c built with the register model
+ *               sys.h of this directory) in virtual time, so the ingestion
+ *               design is measured at any baud rate without hardware.
+ *
+ *               line   : bytes arrive at the baud rate (8N1, 10 bits per
+ *                        character) with random extra inter-character gaps
+ *                        (-j). each epoch burst starts at the rxm-rawx frame
+ *                        at its epoch time (as ubxreplay -b) and the line is
+ *                        idle between bursts.
+ *               uart   : a received character sets RXNE and RDR, or ORE if
+ *                        RXNE is still set (the character is lost).
+ *                        USART3_IRQHandler() is called after a random
+ *                        interrupt latency (-l) and takes -c us of cpu.
+ *               main   : the loop of USER/main.c: strread() of usart3_dev
+ *                        and input_demux() at -d us per byte, and -s ms per
+ *                        solved epoch. interrupts taken while the loop runs
+ *                        delay the loop.
+ *
+ *               reported per baud rate: characters lost by overrun (ORE) and
+ *               by receive ring full, ring high-water mark, epochs decoded,
+ *               and latency from the arrival of the rxm-rawx frame end to the
+ *               end of solving the epoch.
+ *
+ * build  : gcc -O2 -I. -I../../HARDWARE/USART3 -I../../HARDWARE/TIMER
+ *              -I../../RTKLIB -o uartsim uartsim.c
+ *              ../../HARDWARE/USART3/usart3.c ../../RTKLIB/ring.c
+ *              ../../RTKLIB/demux.c ../../RTKLIB/ublox.c ../../RTKLIB/rcvraw.c
+ *              ../../RTKLIB/rtkcmn.c ../../RTKLIB/sbas.c -lm
+ *
+ * usage  : uartsim [-b baud[,baud...]] [-l us] [-c us] [-j us] [-d us]
+ *                  [-s ms] file
+ *          -b baud  baud rates (default 115200,230400,460800,921600)
+ *          -l us    max interrupt latency (uniform random) (default 2)
+ *          -c us    cpu time of receive interrupt (default 0.5)
+ *          -j us    max extra gap between characters (uniform random)
+ *                   (default 0)
+ *          -d us    cpu time of demux/decode per byte (default 0.2)
+ *          -s ms    cpu time of solving per epoch (default 10)
+ *
+ *-----------------------------------------------------------------------------*/
+#include "usart3.h"
+
+#define MAXBAUD 16 /* max number of baud rates */
+#define RINGMASK (USART3_MAX_RECV_LEN - 1)
+#define INF 1E99
+
+USART_TypeDef sim_usart3; /* register model */
+RCC_TypeDef sim_rcc;
+GPIO_TypeDef sim_gpio;
+
+extern const strdev_t usart3_dev; /* receiver uart transport (usart3.c) */
+extern void USART3_IRQHandler(void);
+
+typedef struct
+{                       /* epoch burst type */
+    unsigned int start; /* offset of rxm-rawx frame start */
+    unsigned int end;   /* offset of rxm-rawx frame end */
+    double t;           /* epoch time (s) */
+} epoch_t;
+
+static raw_t raw;                /* receiver raw data control */
+static demux_t dmx;              /* stream demultiplexer */
+static epoch_t *epochs;          /* epoch bursts */
+static int nepoch, nmax;         /* number of epoch bursts */
+static unsigned int offset;      /* offset of current byte */
+static double arrtime[USART3_MAX_RECV_LEN]; /* arrival time of bytes in ring */
+static double tproc, tarr;       /* cpu time of main loop, arrival of byte */
+static double cost_solve;        /* cpu time of solving per epoch (s) */
+static double lat[2];            /* latency {sum,max} (s) */
+static int nsolve;               /* number of epochs solved */
+static unsigned int seed = 1;    /* random seed */
+
+/* uniform random number in [0,1) --------------------------------------------*/
+static double urand(void)
+{
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) / 16777216.0;
+}
+/* locate epoch bursts: raw decode callback ----------------------------------*/
+static void epochfunc(raw_t *raw, int stat)
+{
+    epoch_t *p;
+
+    if (stat != 1)
+        return;
+    if (nepoch >= nmax)
+    {
+        if (!(p = (epoch_t *)realloc(epochs, sizeof(epoch_t) * (nmax + 4096))))
+            return;
+        epochs = p;
+        nmax += 4096;
+    }
+    epochs[nepoch].start = offset + 1 - raw->len;
+    epochs[nepoch].end = offset;
+    epochs[nepoch++].t = raw->time.time + raw->time.sec;
+}
+/* solve epochs: raw decode callback of main loop ----------------------------*/
+static void solvefunc(raw_t *raw, int stat)
+{
+    rawevt_t evt;
+    double t;
+
+    (void)stat;
+    while (get_rawevt(raw, &evt))
+    {
+        if (evt.type != EVT_OBS)
+            continue;
+        tproc += cost_solve;
+        t = tproc - tarr;
+        lat[0] += t;
+        if (t > lat[1])
+            lat[1] = t;
+        nsolve++;
+    }
+}
+/* receive interrupt ---------------------------------------------------------*/
+static void isr(double trdr)
+{
+    unsigned int head = USART3_RX_RING.head;
+
+    USART3_IRQHandler();
+    if (sim_usart3.ICR & (1 << 3)) /* clear ORE */
+        sim_usart3.ISR &= ~(1u << 3);
+    sim_usart3.ICR = 0;
+    sim_usart3.ISR &= ~(1u << 5); /* RXNE cleared by reading RDR */
+    if (USART3_RX_RING.head != head)
+        arrtime[head & RINGMASK] = trdr;
+}
+/* main loop: read receive ring and decode -----------------------------------*/
+static int mainloop(double t, double cost_byte)
+{
+    unsigned char buff[USART3_MAX_RECV_LEN];
+    unsigned int tail = USART3_RX_RING.tail;
+    int i, n;
+
+    if ((n = usart3_dev.read(&USART3_RX_RING, buff, sizeof(buff), NULL)) <= 0)
+        return 0;
+    tproc = t;
+    for (i = 0; i < n; i++)
+    {
+        tproc += cost_byte;
+        tarr = arrtime[(tail + i) & RINGMASK];
+        input_demux(&dmx, buff + i, 1);
+    }
+    return n;
+}
+/* arrival time of characters on line ------------------------------------------
+ * characters are sent back to back (plus random gap) and each epoch burst
+ * starts at its epoch time. return the number of bursts longer than the epoch
+ * interval.
+ *----------------------------------------------------------------------------*/
+static int arrival(unsigned int size, double tb, double jit, double *tch)
+{
+    double t = epochs[0].t - epochs[0].start * tb, tn;
+    unsigned int i;
+    int k = 0, nover = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        tn = t + tb + jit * urand();
+        if (k < nepoch && i == epochs[k].start)
+        {
+            if (tn < epochs[k].t + tb)
+                tn = epochs[k].t + tb; /* idle line until epoch */
+            else if (k > 0)
+                nover++;
+            k++;
+        }
+        tch[i] = t = tn;
+    }
+    return nover;
+}
+/* simulate receive ingestion at baud rate -----------------------------------*/
+static void simulate(const unsigned char *buff, unsigned int size, double baud,
+                     const double *opt, double *tch)
+{
+    double tb = 10.0 / baud, lmax = opt[0] * 1E-6, cisr = opt[1] * 1E-6;
+    double tisr = INF, tisrend = -INF, trdr = 0.0, tcpu = 0.0, tnext;
+    unsigned int i = 0, nin = 0, nlost = 0;
+    int n, idle = 1, nover;
+
+    seed = 1;
+    nover = arrival(size, tb, opt[2] * 1E-6, tch);
+    usart3_init(54, (u32)baud);
+    memset(&sim_usart3, 0, sizeof(sim_usart3));
+    USART3_ORE_CNT = 0;
+    init_raw(&raw);
+    init_demux(&dmx, &raw);
+    dmx.rawfunc = solvefunc;
+    memset(lat, 0, sizeof(lat));
+    nsolve = 0;
+
+    while (i < size || tisr < INF || !idle)
+    {
+        tnext = i < size ? tch[i] : INF;
+
+        if (!idle && tcpu <= tnext && tcpu <= tisr) /* main loop */
+        {
+            if ((n = mainloop(tcpu, opt[3] * 1E-6)) > 0)
+            {
+                nin += n;
+                tcpu = tproc;
+            }
+            else
+                idle = 1;
+        }
+        else if (tisr <= tnext) /* receive interrupt */
+        {
+            isr(trdr);
+            tisrend = tisr + cisr;
+            if (idle)
+            {
+                tcpu = tisrend;
+                idle = 0;
+            }
+            else if (tcpu > tisr)
+                tcpu += cisr; /* main loop preempted */
+            tisr = INF;
+        }
+        else /* character received */
+        {
+            if (sim_usart3.ISR & (1 << 5))
+            {
+                sim_usart3.ISR |= 1 << 3; /* overrun: character lost */
+                nlost++;
+            }
+            else
+            {
+                sim_usart3.RDR = buff[i];
+                sim_usart3.ISR |= 1 << 5;
+                trdr = tnext;
+                tisr = tnext + lmax * urand();
+                if (tisr < tisrend)
+                    tisr = tisrend;
+            }
+            i++;
+        }
+    }
+    printf("%7.0f %10u %10u %7u %6u %8u %6u %7d %8.2f %8.2f %5.1f %5d\n", baud,
+           size, nin, nlost, USART3_ORE_CNT, USART3_RX_RING.nlost,
+           USART3_RX_RING.hwm, nsolve, nsolve > 0 ? lat[0] / nsolve * 1E3 : 0.0,
+           lat[1] * 1E3, size * tb / (tch[size - 1] - tch[0] + tb) * 100.0, nover);
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    double baud[MAXBAUD] = {115200, 230400, 460800, 921600};
+    double opt[4] = {2.0, 0.5, 0.0, 0.2}; /* latency,isr,jitter,decode (us) */
+    unsigned char *buff;
+    const char *file = NULL;
+    double *tch;
+    char *p;
+    long size;
+    int i, nbaud = 4;
+    FILE *fp;
+
+    cost_solve = 10E-3;
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-b") && i + 1 < argc)
+        {
+            for (nbaud = 0, p = strtok(argv[++i], ","); p && nbaud < MAXBAUD;
+                 p = strtok(NULL, ","))
+                baud[nbaud++] = atof(p);
+        }
+        else if (!strcmp(argv[i], "-l") && i + 1 < argc)
+            opt[0] = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+            opt[1] = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+            opt[2] = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+            opt[3] = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            cost_solve = atof(argv[++i]) * 1E-3;
+        else if (argv[i][0] != '-' && !file)
+            file = argv[i];
+        else
+            break;
+    }
+    if (i < argc || !file)
+    {
+        fprintf(stderr, "usage: uartsim [-b baud[,baud...]] [-l us] [-c us] "
+                        "[-j us] [-d us] [-s ms] file\n");
+        return -1;
+    }
+    if (!(fp = fopen(file, "rb")))
+    {
+        fprintf(stderr, "file open error: %s\n", file);
+        return -1;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (size <= 0 || !(buff = (unsigned char *)malloc(size)) ||
+        fread(buff, 1, size, fp) != (size_t)size)
+    {
+        fprintf(stderr, "file read error: %s\n", file);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    /* locate rxm-rawx frames byte by byte */
+    init_raw(&raw);
+    init_demux(&dmx, &raw);
+    dmx.rawfunc = epochfunc;
+    for (offset = 0; offset < (unsigned int)size; offset++)
+        input_demux(&dmx, buff + offset, 1);
+    if (nepoch <= 0)
+    {
+        fprintf(stderr, "no rxm-rawx epoch: %s\n", file);
+        return -1;
+    }
+    printf("ring %d bytes, irq latency <%.1f us, irq %.2f us, gap <%.1f us, "
+           "decode %.2f us/byte, solve %.1f ms\n",
+           USART3_MAX_RECV_LEN, opt[0], opt[1], opt[2], opt[3], cost_solve * 1E3);
+    printf("   baud      bytes       read orelost   ore ringfull    hwm  epochs  lat(ms)  max(ms) load%%  over\n");
+    if (!(tch = (double *)malloc(sizeof(double) * size)))
+        return -1;
+    for (i = 0; i < nbaud; i++)
+        simulate(buff, (unsigned int)size, baud[i], opt, tch);
+    free(tch);
+    free(buff);
+    free(epochs);
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*------------------------------------------------------------------------------
+ * ubxcfg.c : ublox receiver configuration blob generator (host)
+ *
+ * description : generate a c source of ready-to-send ubx cfg frames from a
+ *               receiver profile at build time, so the firmware streams the
+ *               configuration with send_ubxcfg() without parsing strings.
+ *               the profile has one gen_ubx() message string per line
+ *               ("CFG-RATE 1000 1 1" etc.). text after '#' is a comment.
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o ubxcfg ubxcfg.c ../../RTKLIB/ublox.c
+ *              ../../RTKLIB/rcvraw.c ../../RTKLIB/rtkcmn.c ../../RTKLIB/sbas.c -lm
+ *
+ * usage  : ubxcfg [-n name] [-o file] profile
+ *          -n name  name of blob array (default ubxprofile)
+ *          -o file  output c source (default stdout)
+ *
+ *          ubxcfg -o ../../USER/ubxprofile.c m8t.cfg
+ *
+ *-----------------------------------------------------------------------------*/
+#include <ctype.h>
+#include "rtklib.h"
+
+#define MAXBLOB 4096 /* max length of cfg blob (bytes) */
+
+/* read profile and generate cfg blob ----------------------------------------*/
+static int genblob(FILE *fp, FILE *ofp, const char *name)
+{
+    unsigned char buff[1024];
+    char line[1024], *p;
+    int i, n, nblob = 0, nfrm = 0, lineno = 0;
+
+    fprintf(ofp, "const unsigned char %s[] = {\n", name);
+
+    while (fgets(line, sizeof(line), fp))
+    {
+        lineno++;
+        if ((p = strchr(line, '#')))
+            *p = '\0';
+        for (p = line + strlen(line) - 1; p >= line && isspace((unsigned char)*p); p--)
+            *p = '\0';
+        for (p = line; isspace((unsigned char)*p); p++)
+            ;
+        if (!*p)
+            continue;
+
+        if (!(n = gen_ubx(p, buff)))
+        {
+            fprintf(stderr, "profile error: line %d: %s\n", lineno, p);
+            return 0;
+        }
+        if ((nblob += n) > MAXBLOB || ++nfrm > MAXUBXCFG)
+        {
+            fprintf(stderr, "profile too large: line %d\n", lineno);
+            return 0;
+        }
+        fprintf(ofp, "    /* %s */\n", p);
+        for (i = 0; i < n; i++)
+        {
+            fprintf(ofp, "%s0x%02X,%s", i % 12 == 0 ? "    " : "", buff[i],
+                    i % 12 == 11 || i == n - 1 ? "\n" : " ");
+        }
+    }
+    fprintf(ofp, "};\n");
+    fprintf(ofp, "const int %s_len = sizeof(%s); /* %d frames */\n", name, name, nfrm);
+    return nfrm;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    FILE *fp, *ofp = stdout;
+    const char *name = "ubxprofile", *ofile = NULL, *file = NULL;
+    int i, stat;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            name = argv[++i];
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            ofile = argv[++i];
+        else
+            file = argv[i];
+    }
+    if (!file)
+    {
+        fprintf(stderr, "usage: ubxcfg [-n name] [-o file] profile\n");
+        return -1;
+    }
+    if (!(fp = fopen(file, "r")))
+    {
+        fprintf(stderr, "file open error: %s\n", file);
+        return -1;
+    }
+    if (ofile && !(ofp = fopen(ofile, "w")))
+    {
+        fprintf(stderr, "file open error: %s\n", ofile);
+        fclose(fp);
+        return -1;
+    }
+    fprintf(ofp, "/* ubx cfg blob generated by ubxcfg from %s (do not edit) */\n",
+            file);
+    stat = genblob(fp, ofp, name);
+    fclose(fp);
+    if (ofile)
+        fclose(ofp);
+    return stat ? 0 : -1;
+}
@@ -0,0 +1,309 @@
+/*------------------------------------------------------------------------------
+ * ubxcktest.c : ubx checksum test (host)
+ *
+ * description : generate a stream of ubx frames with flipped payload and
+ *               checksum bytes and input it to the ubx decoder by both the
+ *               per-byte path (input_ubx()) and the block path
+ *               (input_ubx_block()) in blocks of random length, so frames are
+ *               decoded in place and assembled over block ends.
+ *               each frame is tested by the plain fletcher checksum of the
+ *               frame (as checksum() of ublox.c before the running checksum).
+ *               the test fails unless both paths return -1 for every frame
+ *               of a decoded message with checksum error and no other, and
+ *               count the same checksum errors by message in raw->ubxstat.
+ *               the good frames are built to decode with status 0 (ack,
+ *               nav-clock without time, rxm-rawx of week 0) and frames of a
+ *               message without decoder (mon-hw) are included.
+               then short frames of every decoded message (payload shorter
+               than the fixed header, valid checksum) are decoded in place at
+               the end of a buffer followed by an inaccessible guard page, so
+               a decoder reading past the frame end faults. both paths must
+               return -1 for them.
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o ubxcktest ubxcktest.c ../../RTKLIB/ublox.c
+ *              ../../RTKLIB/rcvraw.c ../../RTKLIB/rtkcmn.c ../../RTKLIB/sbas.c
+ *              ../../RTKLIB/ubxlog.c -lm
+ *
+ * usage  : ubxcktest [-n num] [-s seed]
+ *          -n num      number of frames (default 100000)
+ *          -s seed     random seed (default 1)
+ *
+ *          exit status 0: ok, 1: test failed
+ *
+ *-----------------------------------------------------------------------------*/
+#include <sys/mman.h>
+#include <unistd.h>
+#include "rtklib.h"
+
+#define MAXGAP 16 /* max bytes between frames */
+
+typedef struct
+{                        /* test message type */
+    unsigned short type; /* message class/id */
+    int len;             /* payload length (bytes) (0: random) */
+    int dec;             /* message with decoder */
+} testmsg_t;
+
+static const testmsg_t msgs[] = {
+    {0x0501, 2, 1},   /* ack-ack */
+    {0x0500, 2, 1},   /* ack-nak */
+    {0x0122, 20, 1},  /* nav-clock */
+    {0x0215, 16, 1},  /* rxm-rawx (week 0, no measurement) */
+    {0x0A09, 0, 0}};  /* mon-hw (no decoder) */
+
+#define NMSG ((int)(sizeof(msgs) / sizeof(testmsg_t)))
+
+static const testmsg_t shorts[] = { /* decoded message (len: fixed header) */
+    {0x0210, 8, 1},   /* rxm-raw */
+    {0x0211, 34, 1},  /* rxm-sfrb */
+    {0x0213, 8, 1},   /* rxm-sfrbx */
+    {0x0215, 16, 1},  /* rxm-rawx */
+    {0x0107, 92, 1},  /* nav-pvt */
+    {0x0122, 20, 1},  /* nav-clock */
+    {0x0135, 8, 1},   /* nav-sat */
+    {0x0D01, 16, 1},  /* tim-tp */
+    {0x0501, 2, 1}};  /* ack-ack */
+
+#define NSHORT ((int)(sizeof(shorts) / sizeof(testmsg_t)))
+
+static int nbad[NMSG];   /* number of checksum errors by message */
+static int nblk;         /* number of -1 status by block path */
+
+/* reference checksum (class to end of payload) ------------------------------*/
+static int checksum_ref(const unsigned char *buff, int len)
+{
+    unsigned char cka = 0, ckb = 0;
+    int i;
+
+    for (i = 2; i < len - 2; i++)
+    {
+        cka += buff[i];
+        ckb += cka;
+    }
+    return cka == buff[len - 2] && ckb == buff[len - 1];
+}
+/* generate frame with flipped bytes -------------------------------------------
+ * return : frame length (bytes), *bad: frame with checksum error
+ *-----------------------------------------------------------------------------*/
+static int genframe(unsigned char *buff, int k, int *bad)
+{
+    unsigned char cka = 0, ckb = 0;
+    int i, n, len = msgs[k].len ? msgs[k].len : rand() % 300;
+
+    buff[0] = 0xB5;
+    buff[1] = 0x62;
+    buff[2] = (unsigned char)(msgs[k].type >> 8);
+    buff[3] = (unsigned char)msgs[k].type;
+    buff[4] = (unsigned char)len;
+    buff[5] = (unsigned char)(len >> 8);
+    for (i = 0; i < len; i++)
+        buff[6 + i] = (unsigned char)rand();
+    if (msgs[k].type == 0x0215)
+    {
+        buff[6 + 8] = buff[6 + 9] = 0; /* week 0 */
+        buff[6 + 11] = 0;              /* no measurement */
+    }
+    for (i = 2; i < len + 6; i++)
+    {
+        cka += buff[i];
+        ckb += cka;
+    }
+    buff[len + 6] = cka;
+    buff[len + 7] = ckb;
+
+    /* flip payload and checksum bytes */
+    switch (rand() % 4)
+    {
+    case 1:
+        if (len > 0)
+            buff[6 + rand() % len] ^= (unsigned char)(1 << rand() % 8);
+        break;
+    case 2:
+        buff[len + 6 + rand() % 2] ^= (unsigned char)(rand() % 255 + 1);
+        break;
+    case 3:
+        for (i = 0, n = rand() % 4 + 1; i < n; i++)
+            buff[6 + rand() % (len + 2)] ^= (unsigned char)rand();
+        break;
+    }
+    *bad = !checksum_ref(buff, len + 8);
+    return len + 8;
+}
+/* block path callback -------------------------------------------------------*/
+static void rawfunc(raw_t *raw, int stat)
+{
+    (void)raw;
+    if (stat == -1)
+        nblk++;
+}
+/* short frames at buffer end -------------------------------------------------
+ * return : number of errors
+ *-----------------------------------------------------------------------------*/
+static int shorttest(void)
+{
+    static raw_t raw;
+    unsigned char *page, *frm, cka, ckb;
+    long size = sysconf(_SC_PAGESIZE);
+    int i, j, k, len, stat, nerr = 0, ntest = 0;
+
+    if ((page = (unsigned char *)mmap(NULL, size * 2, PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED ||
+        mprotect(page + size, size, PROT_NONE))
+    {
+        fprintf(stderr, "guard page error\n");
+        return 1;
+    }
+    init_raw(&raw);
+    for (k = 0; k < NSHORT; k++)
+    {
+        for (len = 0; len < shorts[k].len; len++)
+        {
+            frm = page + size - (len + 8);
+            frm[0] = 0xB5;
+            frm[1] = 0x62;
+            frm[2] = (unsigned char)(shorts[k].type >> 8);
+            frm[3] = (unsigned char)shorts[k].type;
+            frm[4] = (unsigned char)len;
+            frm[5] = (unsigned char)(len >> 8);
+            for (i = 0; i < len; i++)
+                frm[6 + i] = (unsigned char)rand();
+            for (i = 2, cka = ckb = 0; i < len + 6; i++)
+            {
+                cka += frm[i];
+                ckb += cka;
+            }
+            frm[len + 6] = cka;
+            frm[len + 7] = ckb;
+
+            nblk = 0;
+            input_ubx_block(&raw, frm, len + 8, rawfunc);
+            if ((stat = input_ubxfrm(&raw, frm, len + 8)) != -1 || nblk != 1)
+            {
+                if (nerr++ < 10)
+                    fprintf(stderr, "0x%04X len=%d: status %d input_ubxfrm %d errors "
+                            "input_ubx_block\n", shorts[k].type, len, stat, nblk);
+            }
+            ntest++;
+        }
+    }
+    /* frame shorter than header and checksum */
+    for (len = 0; len < 8; len++)
+    {
+        frm = page + size - len;
+        for (j = 0; j < len; j++)
+            frm[j] = "\xB5\x62\x02\x15\x00\x00\x00\x00"[j];
+        if ((stat = input_ubxfrm(&raw, frm, len)) != -1 && nerr++ < 10)
+            fprintf(stderr, "len=%d: status %d input_ubxfrm\n", len, stat);
+        ntest++;
+    }
+    printf("short  : %12d frames at buffer end\n", ntest);
+    munmap(page, size * 2);
+    return nerr;
+}
+/* checksum errors of message in statistics ----------------------------------*/
+static unsigned int getncs(const raw_t *raw, int type)
+{
+    int i;
+
+    for (i = 0; i < NUBXSTAT; i++)
+    {
+        if (raw->ubxstat[i].type == type)
+            return raw->ubxstat[i].ncs;
+    }
+    return 0;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    static raw_t raw1, raw2;
+    unsigned char *buff;
+    int *pos, i, j, k, m, n = 100000, seed = 1, nbyte = 0, bad, nerr = 0, nexp = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            n = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            seed = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: ubxcktest [-n num] [-s seed]\n");
+            return 1;
+        }
+    }
+    if (n < 1 || !(buff = (unsigned char *)malloc((size_t)n * (MAXGAP + 308))) ||
+        !(pos = (int *)calloc(n, sizeof(int))))
+    {
+        fprintf(stderr, "memory allocation error\n");
+        return 1;
+    }
+    srand(seed);
+
+    /* frames between gaps without sync code, pos: end of frame with error */
+    for (i = 0; i < n; i++)
+    {
+        for (j = rand() % (MAXGAP + 1); j > 0; j--)
+        {
+            while ((buff[nbyte] = (unsigned char)rand()) == 0xB5)
+                ;
+            nbyte++;
+        }
+        k = rand() % NMSG;
+        nbyte += genframe(buff + nbyte, k, &bad);
+        if (bad)
+            nbad[k]++;
+        pos[i] = bad && msgs[k].dec ? nbyte : 0;
+    }
+    /* per-byte path */
+    init_raw(&raw1);
+    for (i = j = 0; i < nbyte; i++)
+    {
+        m = input_ubx(&raw1, buff[i]);
+        while (j < n && !pos[j])
+            j++;
+        if (j < n && pos[j] == i + 1)
+        {
+            nexp++;
+            j++;
+            if (m == -1)
+                continue;
+        }
+        else if (m == 0)
+            continue;
+        if (nerr++ < 10)
+            fprintf(stderr, "input_ubx: status %d at byte %d\n", m, i);
+    }
+    /* block path */
+    init_raw(&raw2);
+    for (i = 0; i < nbyte; i += m)
+    {
+        m = rand() % 1024 + 1;
+        if (m > nbyte - i)
+            m = nbyte - i;
+        input_ubx_block(&raw2, buff + i, m, rawfunc);
+    }
+    if (nblk != nexp)
+    {
+        fprintf(stderr, "input_ubx_block: %d errors (%d expected)\n", nblk, nexp);
+        nerr++;
+    }
+    printf("frames : %12d (%d bytes)\n", n, nbyte);
+    for (k = 0; k < NMSG; k++)
+    {
+        printf("0x%04X : %12d errors %8u input_ubx %8u input_ubx_block\n",
+               msgs[k].type, nbad[k], getncs(&raw1, msgs[k].type),
+               getncs(&raw2, msgs[k].type));
+        if (getncs(&raw1, msgs[k].type) != (msgs[k].dec ? (unsigned int)nbad[k] : 0) ||
+            getncs(&raw2, msgs[k].type) != getncs(&raw1, msgs[k].type))
+            nerr++;
+    }
+    nerr += shorttest();
+
+    if (nerr)
+    {
+        printf("test failed: %d errors\n", nerr);
+        return 1;
+    }
+    printf("test ok\n");
+    return 0;
+}
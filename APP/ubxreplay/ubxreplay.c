@@ -0,0 +1,463 @@
+/*------------------------------------------------------------------------------
+ * ubxreplay.c : ublox raw log replay (host)
+ *
+ * description : replay ublox raw log files through the receiver decoders and
+ *               report frames/s and epochs/s. the log is mapped to memory and
+ *               frames are decoded in place by input_raw_block(), so no stdio
+ *               call or syscall is issued per frame. with -m, mixed logs
+ *               (ubx/nmea/rtcm 3) are split by input_demux() and per protocol
+ *               throughput is reported. with -b, the log is replayed with
+ *               the timing of a serial line (each epoch burst starts at its
+ *               epoch time) and the latency of solving on rxm-rawx arrival is
+ *               compared with solving after the line is idle. the rawx
+ *               trigger solves at the arrival of the rxm-rawx frame end, so
+ *               its latency is the epoch to frame end time and its latency
+ *               after the frame end is zero by construction. the idle trigger
+ *               latency is reported after the frame end. with -p, the
+ *               log is input byte by byte by input_raw() (the receive loop
+ *               before input_raw_block()) to compare the throughput.
+ *               with -w, valid frames are captured to a time-indexed log
+ *               (ubxlog.c). with -ts/-te, a capture is reprocessed in a time
+ *               window by seeking with its index.
+ *
+ * build  : gcc -O2 -I../../RTKLIB -o ubxreplay ubxreplay.c ../../RTKLIB/ublox.c
+ *              ../../RTKLIB/rcvraw.c ../../RTKLIB/rtkcmn.c ../../RTKLIB/sbas.c
+ *              ../../RTKLIB/demux.c ../../RTKLIB/ubxlog.c -lm
+ *
+ * usage  : ubxreplay [-r n] [-m] [-p] [-s] [-b baud [-i ms]] [-w capture]
+ *                    [-ts time] [-te time] file ...
+ *          -r n   replay each file n times (default 1)
+ *          -m     mixed ubx/nmea/rtcm 3 log (demultiplex before decode)
+ *          -p     per-byte input by input_raw() (ubx log, not with -m/-w)
+ *          -s     output per message type statistics of last run
+ *          -b baud timed replay at baud rate (bps, 8N1), output latency
+ *          -i ms  idle timeout of line idle trigger (default 200)
+ *          -w capture write valid frames to time-indexed capture (with index
+ *                 capture.idx, implies -m)
+ *          -ts time, -te time  reprocess capture file in time window
+ *                 (gpst "y/m/d h:m:s")
+ *
+ *-----------------------------------------------------------------------------*/
+#include <time.h>
+#include "rtklib.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define MAXBLK (1 << 24) /* max bytes per input_raw_block() call */
+#define MAXRECV 2048     /* uart receive buffer of firmware (bytes) */
+
+static raw_t raw;        /* receiver raw data control (too large for stack) */
+static demux_t dmx;      /* stream demultiplexer */
+
+typedef struct
+{                        /* replay counts type */
+    double frame;        /* number of decoded frames (status!=0) */
+    double epoch;        /* number of observation epochs */
+    double eph;          /* number of ephemeris updates */
+    double err;          /* number of error frames */
+    double dframe[NDMX]; /* demux: number of valid frames per protocol */
+    double dbyte[NDMX];  /* demux: number of bytes per protocol */
+    double derr[NDMX];   /* demux: number of checksum/crc errors per protocol */
+    double dskip;        /* demux: number of bytes outside frames */
+} count_t;
+
+static count_t count;
+
+typedef struct
+{                        /* timed replay epoch type */
+    size_t start, end;   /* offset of rxm-rawx frame start/end */
+    double t;            /* epoch time (gpst) (s) */
+    double tend;         /* arrival time of rxm-rawx frame end (s) */
+} epoch_t;
+
+static epoch_t *epochs;  /* rxm-rawx epochs of timed replay */
+static int nepoch, nmax;
+static size_t offset;    /* byte offset of timed replay */
+static ubxlog_t cap;     /* capture log */
+
+/* raw message callback ------------------------------------------------------*/
+static void rawfunc(raw_t *raw, int stat)
+{
+    rawevt_t evt;
+
+    count.frame++;
+    if (stat < 0)
+        count.err++;
+    while (get_rawevt(raw, &evt))
+    {
+        if (evt.type == EVT_OBS)
+            count.epoch++;
+        else if (evt.type == EVT_EPH)
+            count.eph++;
+    }
+}
+/* frame callback of capture ------------------------------------------------*/
+static void capfunc(int type, const unsigned char *frm, int len)
+{
+    (void)type; /* frames of all protocols are captured */
+    write_ubxlog(&cap, frm, len);
+}
+/* rxm-rawx epoch callback of timed replay -----------------------------------*/
+static void epochfunc(raw_t *raw, int stat)
+{
+    epoch_t *p;
+
+    if (stat != 1)
+        return;
+    if (nepoch >= nmax)
+    {
+        if (!(p = (epoch_t *)realloc(epochs, sizeof(epoch_t) * (nmax + 4096))))
+            return;
+        epochs = p;
+        nmax += 4096;
+    }
+    epochs[nepoch].start = offset + 1 - raw->len;
+    epochs[nepoch].end = offset;
+    epochs[nepoch++].t = raw->time.time + raw->time.sec;
+}
+/* timed replay ----------------------------------------------------------------
+ * bytes arrive at baud rate, and each epoch burst starts at its epoch time.
+ * rawx trigger solves at the arrival of rxm-rawx frame end. idle trigger
+ * solves when the line is silent for idle (s) or the receive buffer is full.
+ *----------------------------------------------------------------------------*/
+static void latency(const unsigned char *buff, size_t size, double baud,
+                    double idle)
+{
+    double tb = 10.0 / baud, t, tn, lat, sum[2] = {0}, max[2] = {0};
+    size_t i;
+    int k = 0, e = 0, p = 0, nbuf = 0, nfull = 0;
+
+    /* locate rxm-rawx frames byte by byte */
+    init_raw(&raw);
+    init_demux(&dmx, &raw);
+    dmx.rawfunc = epochfunc;
+    for (offset = 0; offset < size; offset++)
+        input_demux(&dmx, buff + offset, 1);
+    if (nepoch <= 0)
+    {
+        fprintf(stderr, "no rxm-rawx epoch\n");
+        return;
+    }
+    /* arrival time of bytes and solve time of epochs */
+    t = epochs[0].t - epochs[0].start * tb;
+    for (i = 0; i < size; i++)
+    {
+        tn = t + tb;
+        if (k < nepoch && i == epochs[k].start && tn < epochs[k].t + tb)
+            tn = epochs[k++].t + tb;
+        else if (k < nepoch && i == epochs[k].start)
+            k++;
+
+        if (tn - t - tb >= idle) /* idle trigger by silence */
+        {
+            for (nbuf = 0; p < e; p++)
+            {
+                lat = t + idle - epochs[p].tend;
+                sum[1] += lat;
+                if (lat > max[1])
+                    max[1] = lat;
+            }
+        }
+        t = tn;
+        if (e < nepoch && i == epochs[e].end)
+        {
+            epochs[e].tend = t;
+            lat = t - epochs[e++].t;
+            sum[0] += lat;
+            if (lat > max[0])
+                max[0] = lat;
+        }
+        if (++nbuf >= MAXRECV) /* idle trigger by full buffer */
+        {
+            for (nbuf = 0, nfull++; p < e; p++)
+            {
+                lat = t - epochs[p].tend;
+                sum[1] += lat;
+                if (lat > max[1])
+                    max[1] = lat;
+            }
+        }
+    }
+    for (; p < e; p++)
+    {
+        lat = t + idle - epochs[p].tend;
+        sum[1] += lat;
+        if (lat > max[1])
+            max[1] = lat;
+    }
+    printf("epochs : %12d (%.0f bps, idle %.0f ms)\n", nepoch, baud, idle * 1E3);
+    printf("rawx   : epoch -> frame end   mean %8.1f ms max %8.1f ms (rawx trigger)\n",
+           sum[0] / nepoch * 1E3, max[0] * 1E3);
+    printf("solve  : idle trigger         mean %8.1f ms max %8.1f ms after frame end "
+           "(%d by full buffer)\n",
+           sum[1] / nepoch * 1E3, max[1] * 1E3, nfull);
+}
+/* current time (s) ----------------------------------------------------------*/
+static double tickd(void)
+{
+#ifdef WIN32
+    return GetTickCount() * 1E-3;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1E-9;
+#endif
+}
+/* map file to memory --------------------------------------------------------*/
+static unsigned char *mapfile(const char *file, size_t *size)
+{
+#ifdef WIN32
+    HANDLE fh, mh;
+    unsigned char *p;
+    LARGE_INTEGER n;
+
+    fh = CreateFile(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                    FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fh == INVALID_HANDLE_VALUE)
+        return NULL;
+    if (!GetFileSizeEx(fh, &n) || n.QuadPart == 0 ||
+        !(mh = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL)))
+    {
+        CloseHandle(fh);
+        return NULL;
+    }
+    p = (unsigned char *)MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mh);
+    CloseHandle(fh);
+    *size = (size_t)n.QuadPart;
+    return p;
+#else
+    struct stat st;
+    void *p;
+    int fd;
+
+    if ((fd = open(file, O_RDONLY)) < 0)
+        return NULL;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return NULL;
+    madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+    *size = (size_t)st.st_size;
+    return (unsigned char *)p;
+#endif
+}
+/* unmap file ----------------------------------------------------------------*/
+static void unmapfile(unsigned char *p, size_t size)
+{
+#ifdef WIN32
+    UnmapViewOfFile(p);
+#else
+    munmap(p, size);
+#endif
+}
+/* replay log file -----------------------------------------------------------*/
+static int replay(const char *file, int nrep, int mixed, int perbyte,
+                  double baud, double idle, double *bytes)
+{
+    unsigned char *buff;
+    size_t size, i;
+    int j, k, n, stat;
+
+    if (!(buff = mapfile(file, &size)))
+    {
+        fprintf(stderr, "file open error: %s\n", file);
+        return 0;
+    }
+    if (baud > 0.0)
+    {
+        latency(buff, size, baud, idle);
+        unmapfile(buff, size);
+        return 1;
+    }
+    for (j = 0; j < nrep; j++)
+    {
+        init_raw(&raw);
+        init_demux(&dmx, &raw);
+        dmx.rawfunc = rawfunc;
+        if (cap.fp)
+            dmx.func = capfunc;
+        for (i = 0; perbyte && i < size; i++)
+        {
+            if ((stat = input_raw(&raw, STRFMT_UBX, buff[i])) != 0)
+                rawfunc(&raw, stat);
+        }
+        for (i = 0; !perbyte && i < size; i += n)
+        {
+            n = size - i < MAXBLK ? (int)(size - i) : MAXBLK;
+            if (mixed)
+                input_demux(&dmx, buff + i, n);
+            else
+                input_raw_block(&raw, STRFMT_UBX, buff + i, n, rawfunc);
+        }
+        for (k = 0; k < NDMX; k++)
+        {
+            count.dframe[k] += dmx.nframe[k];
+            count.dbyte[k] += dmx.nbytes[k];
+            count.derr[k] += dmx.nerr[k];
+        }
+        count.dskip += dmx.nskip;
+        *bytes += size;
+    }
+    unmapfile(buff, size);
+    return 1;
+}
+/* reprocess capture in time window ------------------------------------------*/
+static int window(const char *file, gtime_t ts, gtime_t te)
+{
+    ubxlog_t log;
+    double t, tseek;
+    unsigned int off;
+    int stat, n = 0, nskip = 0;
+
+    t = tickd();
+    if (!open_ubxlog(&log, file, 0, 0))
+    {
+        fprintf(stderr, "file open error: %s\n", file);
+        return 0;
+    }
+    off = seek_ubxlog(&log, ts);
+    tseek = tickd() - t;
+
+    init_raw(&raw);
+    while ((stat = input_ubxf(&raw, log.fp)) >= -1)
+    {
+        if (stat != 1)
+            continue;
+        if (timediff(raw.time, ts) < 0.0)
+        {
+            nskip++;
+            continue;
+        }
+        if (te.time && timediff(raw.time, te) > 0.0)
+            break;
+        count.epoch++;
+        n++;
+    }
+    t = tickd() - t;
+    printf("index  : %12d records (%s)\n", log.n, log.index ? "ok" : "none");
+    printf("seek   : %12u offset (%8.3f ms)\n", off, tseek * 1E3);
+    printf("window : %12d epochs (%d skipped before start) %8.3f ms\n", n, nskip,
+           t * 1E3);
+    close_ubxlog(&log);
+    return 1;
+}
+/* string to time (y/m/d h:m:s) ----------------------------------------------*/
+static int str2gt(const char *s, gtime_t *t)
+{
+    double ep[6] = {0};
+
+    if (sscanf(s, "%lf/%lf/%lf %lf:%lf:%lf", ep, ep + 1, ep + 2, ep + 3, ep + 4,
+               ep + 5) < 3)
+        return 0;
+    *t = epoch2time(ep);
+    return 1;
+}
+/* main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+    const char *proto[] = {"ubx", "nmea", "rtcm3"};
+    static unsigned char buff[MAXSOLMSG];
+    const char *capfile = NULL;
+    gtime_t ts = {0}, te = {0};
+    double t, bytes = 0.0, baud = 0.0, idle = 0.2;
+    int i, nrep = 1, mixed = 0, perbyte = 0, stat = 0, nfile = 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            nrep = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-m"))
+            mixed = 1;
+        else if (!strcmp(argv[i], "-p"))
+            perbyte = 1;
+        else if (!strcmp(argv[i], "-s"))
+            stat = 1;
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+            baud = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc)
+            idle = atof(argv[++i]) * 1E-3;
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+            capfile = argv[++i];
+        else if (!strcmp(argv[i], "-ts") && i + 1 < argc)
+            str2gt(argv[++i], &ts);
+        else if (!strcmp(argv[i], "-te") && i + 1 < argc)
+            str2gt(argv[++i], &te);
+        else
+            argv[nfile++] = argv[i];
+    }
+    if (nfile <= 0 || nrep <= 0)
+    {
+        fprintf(stderr, "usage: ubxreplay [-r n] [-m] [-p] [-s] [-b baud [-i ms]] "
+                        "[-w capture] [-ts time] [-te time] file ...\n");
+        return -1;
+    }
+    if (ts.time)
+    {
+        for (i = 0; i < nfile; i++)
+        {
+            if (!window(argv[i], ts, te))
+                return -1;
+        }
+        return 0;
+    }
+    if (capfile)
+    {
+        if (!open_ubxlog(&cap, capfile, 1, 0))
+        {
+            fprintf(stderr, "file open error: %s\n", capfile);
+            return -1;
+        }
+        mixed = 1;
+        nrep = 1;
+    }
+    t = tickd();
+    for (i = 0; i < nfile; i++)
+    {
+        if (!replay(argv[i], nrep, mixed, perbyte && !mixed, baud, idle, &bytes))
+            return -1;
+    }
+    if (cap.fp)
+        close_ubxlog(&cap);
+    if (baud > 0.0)
+        return 0;
+    t = tickd() - t;
+    if (t <= 0.0)
+        t = 1E-9;
+
+    printf("bytes  : %12.0f (%8.1f MB/s)\n", bytes, bytes / t * 1E-6);
+    printf("frames : %12.0f (%8.0f frames/s)\n", count.frame, count.frame / t);
+    printf("epochs : %12.0f (%8.0f epochs/s)\n", count.epoch, count.epoch / t);
+    printf("ephem  : %12.0f\n", count.eph);
+    printf("errors : %12.0f\n", count.err);
+    printf("nav    : %12u decoded %u skipped (last run)\n", raw.nnav[0], raw.nnav[1]);
+    if (mixed)
+    {
+        for (i = 0; i < NDMX; i++)
+        {
+            printf("%-6s : %12.0f frames %12.0f bytes (%8.1f MB/s) %8.0f errors\n",
+                   proto[i], count.dframe[i], count.dbyte[i],
+                   count.dbyte[i] / t * 1E-6, count.derr[i]);
+        }
+        printf("skip   : %12.0f bytes\n", count.dskip);
+    }
+    printf("time   : %12.3f s\n", t);
+    if (stat)
+    {
+        outubxstat(buff, &raw);
+        fputs((char *)buff, stdout);
+    }
+    return 0;
+}
@@ -4,13 +4,11 @@
 
 
 
-extern vu16 USART3_RX_STA;
 //ʱ7жϷ		    
 void TIM7_IRQHandler(void)
 { 	  		    
 	if(TIM7->SR&0X01)//Ǹж
 	{	 			   
-		USART3_RX_STA|=1<<15;	//ǽ
 		TIM7->SR&=~(1<<0);		//жϱ־λ		   
 		TIM7->CR1&=~(1<<0);		//رնʱ7	  
 	}	      											 
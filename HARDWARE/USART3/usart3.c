@@ -10,37 +10,23 @@
 //ڷͻ 	
 __align(8) u8 USART3_TX_BUF[USART3_MAX_SEND_LEN]; 	//ͻ,USART3_MAX_SEND_LENֽ
 //ڽջ 	
-u8 USART3_RX_BUF[USART3_MAX_RECV_LEN]; 				//ջ,USART3_MAX_RECV_LENֽ.
+u8 USART3_RX_BUF[USART3_MAX_RECV_LEN]; 				//ջλ,USART3_MAX_RECV_LENֽ(2).
 
 
-//ͨжϽ2ַ֮ʱ10msǲһ.
-//2ַռ10ms,Ϊ1.Ҳǳ10msûнյ
-//κ,ʾ˴ν.
-//յ״̬
-//[15]:0,ûнյ;1,յһ.
-//[14:0]:յݳ
-vu16 USART3_RX_STA=0;   	 
+//ջλ:жд(),ѭpeek_ring/skip_ringԭضȡ(),ж.
+//ѭڼյݼд뻷λ,Ŷ(USART3_RX_RING.nlost)
+ring_t USART3_RX_RING;
+u32 USART3_ORE_CNT=0;								//Ӳ
 void USART3_IRQHandler(void)
 {
-	u8 res;	     
+	if(USART3->ISR&(1<<3))//(ORE),־,жϷ
+	{
+		USART3->ICR=1<<3;
+		USART3_ORE_CNT++;
+	}
 	if(USART3->ISR&(1<<5))//յ
 	{	 
-		res=USART3->RDR; 			 
-		if((USART3_RX_STA&(1<<15))==0)//һ,ûб,ٽ
-		{ 
-			if(USART3_RX_STA<USART3_MAX_RECV_LEN)	//Խ
-			{
-				TIM7->CNT=0;         				//
-				if(USART3_RX_STA==0) 				//ʹܶʱ7ж 
-				{
-					TIM7->CR1|=1<<0;     			//ʹܶʱ7
-				}
-				USART3_RX_BUF[USART3_RX_STA++]=res;	//¼յֵ	 
-			}else 
-			{
-				USART3_RX_STA|=1<<15;				//ǿƱǽ
-			} 
-		}
+		put_ring(&USART3_RX_RING,USART3->RDR);	//д뻷λ
 	}  				 											 
 }   
 //ʼIO 3
@@ -68,12 +54,64 @@ void usart3_init(u32 pclk1,u32 bound)
 	USART3->CR1|=1<<2;  			//ڽʹ
 	USART3->CR1|=1<<5;    			//ջǿжʹ	
 	USART3->CR1|=1<<0;  			//ʹ  
+	init_ring(&USART3_RX_RING,USART3_RX_BUF,USART3_MAX_RECV_LEN);//ʼջλ(ʹжǰ)
 	MY_NVIC_Init(0,0,USART3_IRQn,2);//2ȼ0,0,ȼ 
-	TIM7_Int_Init(2000-1,8400-1);	//200msжһ
-	TIM7->CR1&=~(1<<0);				//رնʱ7
-	USART3_RX_STA=0;				// 
 }
 
+//3
+//buff:
+//n:ݳ
+//ֵ:ʵдֽ(ݼĴΪղд,ȴ)
+int usart3_write(const unsigned char *buff,int n)
+{
+	int i;
+	for(i=0;i<n&&(USART3->ISR&0X80);i++)//TXE
+	{
+		USART3->TDR=buff[i];
+	}
+	return i;
+}
+
+//3Ϊ(stream_t,STR_SERIAL):ȡջλ,
+static void *usart3_open(const char *path,int mode,char *msg)
+{
+	(void)path;(void)mode;(void)msg;
+	return &USART3_RX_RING;				//usart3_initʼ
+}
+static int usart3_read(void *port,unsigned char *buff,int n,char *msg)
+{
+	const unsigned char *p;
+	int len,nr=0;
+	(void)msg;
+	while(nr<n&&(len=peek_ring((ring_t *)port,&p))>0)//λʱζȡ
+	{
+		if(len>n-nr)len=n-nr;
+		memcpy(buff+nr,p,len);
+		skip_ring((ring_t *)port,len);
+		nr+=len;
+	}
+	return nr;
+}
+static int usart3_wr(void *port,const unsigned char *buff,int n,char *msg)
+{
+	(void)port;(void)msg;
+	return usart3_write(buff,n);
+}
+static int usart3_poll(void *port,int tout)//ȴ,Ƿн
+{
+	(void)tout;
+	return ((ring_t *)port)->head!=((ring_t *)port)->tail;
+}
+static void usart3_close(void *port)
+{
+	(void)port;
+}
+static unsigned int usart3_tick(void *port)//ʱ:ждһֽڵDWT
+{
+	return ((ring_t *)port)->tick;
+}
+const strdev_t usart3_dev={usart3_open,usart3_read,usart3_wr,usart3_poll,usart3_close,usart3_tick};
+
 //3,printf 
 //ȷһηݲUSART3_MAX_SEND_LENֽ
 void u3_printf(char* fmt,...)  
@@ -2,18 +2,21 @@
 #define __USART3_H 
 #include "sys.h"
 #include "stdio.h"	  
+#include "rtklib.h"
 
 
-#define USART3_MAX_RECV_LEN		2048					//ջֽ
+#define USART3_MAX_RECV_LEN		2048					//ջֽ(λ,Ϊ2)
 #define USART3_MAX_SEND_LEN		2048					//ͻֽ
 #define USART3_RX_EN 			1					//0,;1,.
 
 extern u8  USART3_RX_BUF[USART3_MAX_RECV_LEN]; 		//ջ,USART3_MAX_RECV_LENֽ
 extern u8  USART3_TX_BUF[USART3_MAX_SEND_LEN]; 		//ͻ,USART3_MAX_SEND_LENֽ
-extern vu16 USART3_RX_STA;   						//״̬
+extern ring_t USART3_RX_RING;						//ջλ(ж->ѭ)
+extern u32 USART3_ORE_CNT;							//Ӳ
 
 void usart3_init(u32 pclk1,u32 bound);
 void u3_printf(char* fmt,...);
+int usart3_write(const unsigned char *buff,int n);
 #endif	   
 
 
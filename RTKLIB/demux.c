@@ -0,0 +1,280 @@
+/*------------------------------------------------------------------------------
+ * demux.c : stream protocol demultiplexer
+ *
+ * description : split a mixed receiver stream (ublox binary, NMEA 0183 and
+ *               RTCM 3) into frames in a single pass, validate each frame by
+ *               the checksum/crc of its protocol and route it to its decoder.
+ *               frames complete in the input block are validated and routed in
+ *               place. only a frame split over the block end is copied to the
+ *               demux buffer.
+ *
+ * reference :
+ *     [1] u-blox 8 / u-blox M8 Receiver Description Including Protocol
+ *         Specification, UBX-13003221, chapter 31 (UBX protocol)
+ *     [2] NMEA 0183 Standard for Interfacing Marine Electronic Devices,
+ *         Version 4.10, 2012
+ *     [3] RTCM Standard 10403.2, Differential GNSS Services - Version 3, 2013
+ *
+ * history : 2026/10/17 1.0 new
+ *-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+#define UBXSYNC1 0xB5    /* ubx message sync code 1 */
+#define UBXSYNC2 0x62    /* ubx message sync code 2 */
+#define NMEASYNC '$'     /* nmea sentence start */
+#define MAXNMEALEN 256   /* max length of nmea sentence (incl. proprietary) */
+
+/* ubx frame checksum (class to end of payload) -------------------------------*/
+static int test_ubx(const unsigned char *frm, int len)
+{
+    unsigned char cka = 0, ckb = 0;
+    int i;
+
+    for (i = 2; i < len - 2; i++)
+    {
+        cka += frm[i];
+        ckb += cka;
+    }
+    return cka == frm[len - 2] && ckb == frm[len - 1];
+}
+/* hex digit value (-1: not hex) ----------------------------------------------*/
+static int hexval(unsigned char c)
+{
+    if ('0' <= c && c <= '9')
+        return c - '0';
+    if ('A' <= c && c <= 'F')
+        return c - 'A' + 10;
+    if ('a' <= c && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+/* nmea sentence checksum ($...*hh[CR]LF) -------------------------------------*/
+static int test_nmea(const unsigned char *frm, int len)
+{
+    unsigned char sum = 0;
+    int i, n = len - 1, h1, h2;
+
+    if (n > 0 && frm[n - 1] == '\r')
+        n--;
+    if (n < 4 || frm[n - 3] != '*')
+        return 0;
+    if ((h1 = hexval(frm[n - 2])) < 0 || (h2 = hexval(frm[n - 1])) < 0)
+        return 0;
+
+    for (i = 1; i < n - 3; i++)
+        sum ^= frm[i];
+    return sum == ((h1 << 4) | h2);
+}
+/* rtcm 3 frame crc-24q -------------------------------------------------------*/
+static int test_rtcm3(const unsigned char *frm, int len)
+{
+    return crc24q(frm, len - 3) == getbitu(frm, (len - 3) * 8, 24);
+}
+/* scan nmea sentence from byte i ----------------------------------------------
+ * return : sentence length (0: incomplete, -1: not a sentence)
+ *----------------------------------------------------------------------------*/
+static int nmealen(const unsigned char *p, int i, int n)
+{
+    for (; i < n && i < MAXNMEALEN; i++)
+    {
+        if (p[i] == '\n')
+            return i + 1;
+        if ((p[i] < 0x20 && p[i] != '\r') || p[i] > 0x7E)
+            return -1;
+    }
+    return i < MAXNMEALEN ? 0 : -1;
+}
+/* frame length from frame header ----------------------------------------------
+ * return : frame length (0: header incomplete, -1: not a frame)
+ *----------------------------------------------------------------------------*/
+static int framelen(int type, const unsigned char *p, int n)
+{
+    int len;
+
+    switch (type)
+    {
+    case DMX_UBX:
+        if (n < 2)
+            return 0;
+        if (p[1] != UBXSYNC2)
+            return -1;
+        if (n < 6)
+            return 0;
+        len = (p[4] | (p[5] << 8)) + 8;
+        return len <= MAXRAWLEN ? len : -1;
+    case DMX_RTCM3:
+        if (n < 2)
+            return 0;
+        if (p[1] & 0xFC) /* reserved bits */
+            return -1;
+        if (n < 3)
+            return 0;
+        return (int)getbitu(p, 14, 10) + 6;
+    }
+    return nmealen(p, 1, n);
+}
+/* validate and route frame to decoder ----------------------------------------*/
+static int route(demux_t *dmx, int type, const unsigned char *frm, int len)
+{
+    int stat, ok;
+
+    switch (type)
+    {
+    case DMX_UBX:
+        ok = test_ubx(frm, len);
+        break;
+    case DMX_RTCM3:
+        ok = test_rtcm3(frm, len);
+        break;
+    default:
+        ok = test_nmea(frm, len);
+        break;
+    }
+    if (!ok)
+    {
+        dmx->nerr[type]++;
+        return 0;
+    }
+    dmx->nframe[type]++;
+    dmx->nbytes[type] += len;
+
+    if (dmx->func)
+    {
+        dmx->func(type, frm, len);
+    }
+    if (type == DMX_UBX && dmx->raw &&
+        (stat = input_ubxfrm(dmx->raw, frm, len)) != 0 && dmx->rawfunc)
+    {
+        dmx->rawfunc(dmx->raw, stat);
+    }
+    return 1;
+}
+/* rescan partial frame after its preamble ----------------------------------
+ * a split frame with invalid header or checksum is taken as a false preamble
+ * and the buffered bytes after it are scanned again, as a failing frame in the
+ * block, so frames are found independent of the block boundaries.
+ *----------------------------------------------------------------------------*/
+static int rescan(demux_t *dmx)
+{
+    int n = dmx->nbyte - 1;
+
+    dmx->nskip++;
+    dmx->nbyte = dmx->len = 0;
+    return n > 0 ? input_demux(dmx, dmx->buff + 1, n) : 0;
+}
+/* initialize stream demultiplexer ---------------------------------------------
+ * args   : demux_t *dmx  O     stream demultiplexer
+ *          raw_t   *raw  I     receiver raw data control for ubx frames
+ *                              (NULL: ubx frames are only counted)
+ * return : none
+ * notes  : set dmx->rawfunc and dmx->func after initialization to receive
+ *          ubx decode status and valid frames.
+ *-----------------------------------------------------------------------------*/
+extern void init_demux(demux_t *dmx, raw_t *raw)
+{
+    memset(dmx, 0, sizeof(demux_t));
+    dmx->raw = raw;
+}
+/* input stream block to demultiplexer -----------------------------------------
+ * classify frames in a block of mixed stream data by preamble, validate them by
+ * the checksum/crc of each protocol and route valid frames:
+ *   ubx (B5 62)    : fletcher checksum -> dmx->func(DMX_UBX,frm,len),
+ *                                         input_ubxfrm(), dmx->rawfunc(raw,stat)
+ *   nmea ($..LF)   : xor checksum *hh  -> dmx->func(DMX_NMEA,frm,len)
+ *   rtcm 3 (D3)    : crc-24q           -> dmx->func(DMX_RTCM3,frm,len)
+ * args   : demux_t *dmx  IO    stream demultiplexer
+ *          unsigned char *buff I stream data
+ *          int    n      I     length of stream data (bytes)
+ * return : number of valid frames in the block
+ * notes  : per protocol frames, bytes and checksum errors are counted in
+ *          dmx->nframe, dmx->nbytes and dmx->nerr. bytes outside valid frames
+ *          are counted in dmx->nskip.
+ *          a frame failing its header or checksum is taken as a false
+ *          preamble and the scan resumes at the byte after the preamble, also
+ *          for a frame split over blocks (buffered bytes are rescanned), so
+ *          the frames found do not depend on the block length.
+ *-----------------------------------------------------------------------------*/
+extern int input_demux(demux_t *dmx, const unsigned char *buff, int n)
+{
+    const unsigned char *p = buff, *q, *end = buff + n;
+    int type, len, nfrm = 0;
+
+    while (p < end)
+    {
+        /* frame header split over blocks */
+        if (dmx->nbyte > 0 && dmx->len == 0)
+        {
+            dmx->buff[dmx->nbyte++] = *p++;
+            if (dmx->type == DMX_NMEA)
+                len = nmealen(dmx->buff, dmx->nbyte - 1, dmx->nbyte);
+            else
+                len = framelen(dmx->type, dmx->buff, dmx->nbyte);
+
+            if (len < 0)
+            {
+                nfrm += rescan(dmx);
+                continue;
+            }
+            if ((dmx->len = len) == 0 || dmx->nbyte < len)
+                continue;
+        }
+        /* frame body split over blocks */
+        if (dmx->nbyte > 0)
+        {
+            len = dmx->len - dmx->nbyte < end - p ? dmx->len - dmx->nbyte : (int)(end - p);
+            memcpy(dmx->buff + dmx->nbyte, p, len);
+            dmx->nbyte += len;
+            p += len;
+            if (dmx->nbyte < dmx->len)
+                break;
+
+            if (!route(dmx, dmx->type, dmx->buff, dmx->len))
+            {
+                nfrm += rescan(dmx);
+                continue;
+            }
+            nfrm++;
+            dmx->nbyte = dmx->len = 0;
+            continue;
+        }
+        /* search preamble */
+        for (q = p; q < end; q++)
+        {
+            if (*q == UBXSYNC1 || *q == NMEASYNC || *q == RTCM3PREAMB)
+                break;
+        }
+        dmx->nskip += q - p;
+        if (q >= end)
+            break;
+
+        type = *q == UBXSYNC1 ? DMX_UBX : (*q == NMEASYNC ? DMX_NMEA : DMX_RTCM3);
+
+        if ((len = framelen(type, q, (int)(end - q))) < 0)
+        {
+            dmx->nskip++;
+            p = q + 1;
+            continue;
+        }
+        /* keep frame split over block end */
+        if (len == 0 || end - q < len)
+        {
+            dmx->type = type;
+            dmx->len = len;
+            dmx->nbyte = (int)(end - q);
+            memmove(dmx->buff, q, dmx->nbyte); /* q in dmx->buff by rescan() */
+            break;
+        }
+        /* validate and route frame in place */
+        if (route(dmx, type, q, len))
+        {
+            nfrm++;
+            p = q + len;
+        }
+        else
+        {
+            dmx->nskip++;
+            p = q + 1;
+        }
+    }
+    return nfrm;
+}
@@ -17,8 +17,6 @@
 
 static const double range[4];       /* embedded geoid area range {W,E,S,N} (deg) */
 static const float geoid[361][181]; /* embedded geoid heights (m) (lon x lat) */
-static FILE *fp_geoid=NULL;         /* geoid file pointer */
-static int model_geoid=GEOID_EMBEDDED; /* geoid model */
 
 /* bilinear interpolation ----------------------------------------------------*/
 static double interpb(const double *y, double a, double b)
@@ -56,23 +54,23 @@ static short fget2b(FILE *fp, long off)
     return ((short)v[0]<<8)+v[1]; /* big-endian */
 }
 /* egm96 15x15" model --------------------------------------------------------*/
-static double geoidh_egm96(const double *pos)
+static double geoidh_egm96(FILE *fp, const double *pos)
 {
     const double lon0=0.0,lat0=90.0,dlon=15.0/60.0,dlat=-15.0/60.0;
     const int nlon=1440,nlat=721;
     double a,b,y[4];
     long i1,i2,j1,j2;
     
-    if (!fp_geoid) return 0.0;
+    if (!fp) return 0.0;
     
     a=(pos[1]-lon0)/dlon;
     b=(pos[0]-lat0)/dlat;
     i1=(long)a; a-=i1; i2=i1<nlon-1?i1+1:0;
     j1=(long)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fget2b(fp_geoid,2L*(i1+j1*nlon))*0.01;
-    y[1]=fget2b(fp_geoid,2L*(i2+j1*nlon))*0.01;
-    y[2]=fget2b(fp_geoid,2L*(i1+j2*nlon))*0.01;
-    y[3]=fget2b(fp_geoid,2L*(i2+j2*nlon))*0.01;
+    y[0]=fget2b(fp,2L*(i1+j1*nlon))*0.01;
+    y[1]=fget2b(fp,2L*(i2+j1*nlon))*0.01;
+    y[2]=fget2b(fp,2L*(i1+j2*nlon))*0.01;
+    y[3]=fget2b(fp,2L*(i2+j2*nlon))*0.01;
     return interpb(y,a,b);
 }
 /* get 4byte float from file -------------------------------------------------*/
@@ -85,7 +83,7 @@ static float fget4f(FILE *fp, long off)
     return v; /* small-endian */
 }
 /* egm2008 model -------------------------------------------------------------*/
-static double geoidh_egm08(const double *pos, int model)
+static double geoidh_egm08(FILE *fp, const double *pos, int model)
 {
     const double lon0=0.0,lat0=90.0;
     double dlon,dlat;
@@ -93,7 +91,7 @@ static double geoidh_egm08(const double *pos, int model)
     long i1,i2,j1,j2;
     int nlon,nlat;
     
-    if (!fp_geoid) return 0.0;
+    if (!fp) return 0.0;
     
     if (model==GEOID_EGM2008_M25) { /* 2.5 x 2.5" grid */
         dlon= 2.5/60.0;
@@ -119,16 +117,16 @@ static double geoidh_egm08(const double *pos, int model)
     /* (2) Und_min2.5x2.5_egm2008_isw=82_WGS84_TideFree_SE.gz */
 #if 0
     /* not zero-inserted */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon)));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon)));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon)));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon)));
+    y[0]=fget4f(fp,4L*(i1+j1*(nlon)));
+    y[1]=fget4f(fp,4L*(i2+j1*(nlon)));
+    y[2]=fget4f(fp,4L*(i1+j2*(nlon)));
+    y[3]=fget4f(fp,4L*(i2+j2*(nlon)));
 #else
     /* zero-inserted version (2009/12/10) */
-    y[0]=fget4f(fp_geoid,4L*(i1+j1*(nlon+2)+1));
-    y[1]=fget4f(fp_geoid,4L*(i2+j1*(nlon+2)+1));
-    y[2]=fget4f(fp_geoid,4L*(i1+j2*(nlon+2)+1));
-    y[3]=fget4f(fp_geoid,4L*(i2+j2*(nlon+2)+1));
+    y[0]=fget4f(fp,4L*(i1+j1*(nlon+2)+1));
+    y[1]=fget4f(fp,4L*(i2+j1*(nlon+2)+1));
+    y[2]=fget4f(fp,4L*(i1+j2*(nlon+2)+1));
+    y[3]=fget4f(fp,4L*(i2+j2*(nlon+2)+1));
 #endif
     return interpb(y,a,b);
 }
@@ -151,7 +149,7 @@ static double fgetgsi(FILE *fp, int nlon, int nlat, int i, int j)
     return v;
 }
 /* gsi geoid 2000 1.0x1.5" model ---------------------------------------------*/
-static double geoidh_gsi(const double *pos)
+static double geoidh_gsi(FILE *fp, const double *pos)
 {
     const double lon0=120.0,lon1=150.0,lat0=20.0,lat1=50.0;
     const double dlon=1.5/60.0,dlat=1.0/60.0;
@@ -159,7 +157,7 @@ static double geoidh_gsi(const double *pos)
     double a,b,y[4];
     int i1,i2,j1,j2;
     
-    if (!fp_geoid||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
+    if (!fp||pos[1]<lon0||lon1<pos[1]||pos[0]<lat0||lat1<pos[0]) {
 //        trace(2,"out of range for gsi geoid: lat=%.3f lon=%.3f\n",pos[0],pos[1]);
         return 0.0;
     }
@@ -167,10 +165,10 @@ static double geoidh_gsi(const double *pos)
     b=(pos[0]-lat0)/dlat;
     i1=(int)a; a-=i1; i2=i1<nlon-1?i1+1:i1;
     j1=(int)b; b-=j1; j2=j1<nlat-1?j1+1:j1;
-    y[0]=fgetgsi(fp_geoid,nlon,nlat,i1,j1);
-    y[1]=fgetgsi(fp_geoid,nlon,nlat,i2,j1);
-    y[2]=fgetgsi(fp_geoid,nlon,nlat,i1,j2);
-    y[3]=fgetgsi(fp_geoid,nlon,nlat,i2,j2);
+    y[0]=fgetgsi(fp,nlon,nlat,i1,j1);
+    y[1]=fgetgsi(fp,nlon,nlat,i2,j1);
+    y[2]=fgetgsi(fp,nlon,nlat,i1,j2);
+    y[3]=fgetgsi(fp,nlon,nlat,i2,j2);
     if (y[0]==999.0||y[1]==999.0||y[2]==999.0||y[3]==999.0) {
 //        trace(2,"geoidh_gsi: data outage (lat=%.3f lon=%.3f)\n",pos[0],pos[1]);
         return 0.0;
@@ -179,7 +177,8 @@ static double geoidh_gsi(const double *pos)
 }
 /* open geoid model file -------------------------------------------------------
 * open geoid model file
-* args   : int    model     I   geoid model type
+* args   : geoid_t *geoid   O   geoid model context
+*          int    model     I   geoid model type
 *                               GEOID_EMBEDDED   : embedded model(1x1deg)
 *                               GEOID_EGM96_M150 : EGM96 15x15"
 *                               GEOID_EGM2008_M25: EGM2008 2.5x2.5"
@@ -194,11 +193,11 @@ static double geoidh_gsi(const double *pos)
 *          gsigeome_ver4 : GSI geoid 2000 1.0x1.5" (japanese area)
 *          (byte-order of binary files must be compatible to cpu)
 *-----------------------------------------------------------------------------*/
-//extern int opengeoid(int model, const char *file)
+//extern int opengeoid(geoid_t *geoid, int model, const char *file)
 //{
 ////    trace(3,"opengeoid: model=%d file=%s\n",model,file);
 //    
-//    closegeoid();
+//    closegeoid(geoid);
 //    if (model==GEOID_EMBEDDED) {
 //        return 1;
 //    }
@@ -207,33 +206,33 @@ static double geoidh_gsi(const double *pos)
 ////        trace(2,"invalid geoid model: model=%d file=%s\n",model,file);
 //        return 0;
 //    }
-//    if (!(fp_geoid=fopen(file,"rb"))) {
+//    if (!(geoid->fp=fopen(file,"rb"))) {
 ////        trace(2,"geoid model file open error: model=%d file=%s\n",model,file);
 //        return 0;
 //    }
-//    model_geoid=model;
+//    geoid->model=model;
 //    return 1;
 //}
 /* close geoid model file ------------------------------------------------------
 * close geoid model file
-* args   : none
+* args   : geoid_t *geoid   IO  geoid model context
 * return : none
 *-----------------------------------------------------------------------------*/
-//extern void closegeoid(void)
+//extern void closegeoid(geoid_t *geoid)
 //{
 ////    trace(3,"closegoid:\n");
 //    
-//    if (fp_geoid) fclose(fp_geoid);
-//    fp_geoid=NULL;
-//    model_geoid=GEOID_EMBEDDED;
+//    if (geoid->fp) fclose(geoid->fp);
+//    geoid->fp=NULL;
+//    geoid->model=GEOID_EMBEDDED;
 //}
 /* geoid height ----------------------------------------------------------------
 * get geoid height from geoid model
 * args   : double *pos      I   geodetic position {lat,lon} (rad)
 * return : geoid height (m) (0.0:error)
-* notes  : to use external geoid model, call function opengeoid() to open
-*          geoid model before calling the function. If the external geoid model
-*          is not open, the function uses embedded geoid model.
+* notes  : only the embedded geoid model is enabled, so the function keeps no
+*          state and is reentrant. external geoid models are read through the
+*          file of a geoid model context opened by opengeoid() (disabled).
 *-----------------------------------------------------------------------------*/
 extern double geoidh(const double *pos)
 {
@@ -245,14 +244,15 @@ extern double geoidh(const double *pos)
 //        trace(2,"out of range for geoid model: lat=%.3f lon=%.3f\n",posd[0],posd[1]);
         return 0.0;
     }
-    switch (model_geoid) {
-        case GEOID_EMBEDDED   : h=geoidh_emb  (posd); break;
-//        case GEOID_EGM96_M150 : h=geoidh_egm96(posd); break;
-//        case GEOID_EGM2008_M25: h=geoidh_egm08(posd,model_geoid); break;
-//        case GEOID_EGM2008_M10: h=geoidh_egm08(posd,model_geoid); break;
-//        case GEOID_GSI2000_M15: h=geoidh_gsi  (posd); break;
-        default: return 0.0;
-    }
+    h=geoidh_emb(posd); /* embedded model only (no file state) */
+//    switch (geoid->model) {
+//        case GEOID_EMBEDDED   : h=geoidh_emb  (posd); break;
+//        case GEOID_EGM96_M150 : h=geoidh_egm96(geoid->fp,posd); break;
+//        case GEOID_EGM2008_M25: h=geoidh_egm08(geoid->fp,posd,geoid->model); break;
+//        case GEOID_EGM2008_M10: h=geoidh_egm08(geoid->fp,posd,geoid->model); break;
+//        case GEOID_GSI2000_M15: h=geoidh_gsi  (geoid->fp,posd); break;
+//        default: return 0.0;
+//    }
     if (fabs(h)>200.0) {
 //        trace(2,"invalid geoid model: lat=%.3f lon=%.3f h=%.3f\n",posd[0],posd[1],h);
         return 0.0;
@@ -33,6 +33,12 @@
 #define ERR_CBIAS 0.3 /* code bias error std (m) */
 #define REL_HUMI 0.7  /* relative humidity for saastamoinen model */
 
+#define MAXDXRAIM 1E-3 /* max update of converged solution for raim fde (m) */
+#define MAXTTWARM 10.0 /* max time difference to previous solution for warm start (s) */
+#define MAXDXCONV 1E-2 /* max update for convergence test by rate of convergence (m) */
+#define MAXDRCORR 10.0 /* max position change to reuse satellite corrections (m) */
+#define MAXDTRCORR 1E-4 /* max error of reused slant tropospheric delay (m) */
+
 const double chisqr[100] = {/* chi-sqr(n) (alpha=0.001) */
                             10.8, 13.8, 16.3, 18.5, 20.5, 22.5, 24.3, 26.1, 27.9, 29.6,
                             31.3, 32.9, 34.5, 36.1, 37.7, 39.3, 40.8, 42.3, 43.8, 45.3,
@@ -45,6 +51,26 @@ const double chisqr[100] = {/* chi-sqr(n) (alpha=0.001) */
                             126, 127, 128, 129, 131, 132, 133, 134, 135, 137,
                             138, 139, 140, 142, 143, 144, 145, 147, 148, 149};
 
+typedef struct
+{                      /* least square accumulator type */
+    int nx;            /* number of parameters (<=NX) */
+    double R[NX * NX]; /* triangular factor R (upper triangle) */
+    double z[NX];      /* rotated weighted residuals (R*dx=z) */
+    double vv;         /* weighted residual square sum */
+    double rss;        /* weighted residual square sum after fit */
+} lsqr_t;
+
+typedef struct
+{                       /* satellite corrections of epoch type */
+    int iter;           /* iteration of corrections (0:first,1:others,-1:none) */
+    double rr[3];       /* receiver position of corrections (ecef) (m) */
+    double zd;          /* zenith tropospheric delay at rr (m) */
+    double drmax;       /* max position change to reuse corrections (m) */
+    double P[MAXOBS];   /* pseudorange corrected for code bias/iono (m) (0:invalid) */
+    double trp[MAXOBS]; /* tropospheric delay at rr (m) */
+    double var[MAXOBS]; /* error variance except sat position/clock (m^2) */
+} corr_t;
+
 /* pseudorange measurement error variance ------------------------------------*/
 /**
  * @brief 计算导航系统伪距测量值的误差
@@ -277,46 +303,161 @@ extern int tropcorr(gtime_t time, const nav_t *nav, const double *pos,
     *var = tropopt == TROPOPT_OFF ? SQR(ERR_TROP) : 0.0;
     return 1;
 }
+/* initialize least square accumulator ---------------------------------------*/
+static void init_lsqr(lsqr_t *lsq, int nx)
+{
+    memset(lsq, 0, sizeof(lsqr_t));
+    lsq->nx = nx;
+}
+/* add measurement row to least square accumulator -----------------------------
+ * args   : lsqr_t *lsq      IO  least square accumulator
+ *          double *h        I   design matrix row (nx x 1)
+ *          double v         I   residual
+ *          double var       I   variance of residual (weight 1/var)
+ * return : none
+ * notes  : the weighted row is rotated into the triangular factor R by givens
+ *          rotations (zero elements of h skipped). the weighted residual left
+ *          after the rotations is added to lsq->rss.
+ *-----------------------------------------------------------------------------*/
+static void addrow_lsqr(lsqr_t *lsq, const double *h, double v, double var)
+{
+    double a[NX], w = 1.0 / sqrt(var), r, c, s, t;
+    int i, j, nx = lsq->nx;
+
+    for (i = 0; i < nx; i++)
+        a[i] = h[i] * w;
+    v *= w;
+    lsq->vv += v * v;
+
+    for (i = 0; i < nx; i++)
+    {
+        if (a[i] == 0.0)
+            continue;
+        if (lsq->R[i + i * nx] == 0.0)
+        { /* empty row of R: take the row */
+            for (j = i; j < nx; j++)
+                lsq->R[i + j * nx] = a[j];
+            lsq->z[i] = v;
+            return;
+        }
+        r = sqrt(SQR(lsq->R[i + i * nx]) + SQR(a[i]));
+        c = lsq->R[i + i * nx] / r;
+        s = a[i] / r;
+        lsq->R[i + i * nx] = r;
+        for (j = i + 1; j < nx; j++)
+        {
+            t = lsq->R[i + j * nx];
+            lsq->R[i + j * nx] = c * t + s * a[j];
+            a[j] = c * a[j] - s * t;
+        }
+        t = lsq->z[i];
+        lsq->z[i] = c * t + s * v;
+        v = c * v - s * t;
+    }
+    lsq->rss += v * v;
+}
+/* solve least square accumulator ----------------------------------------------
+ * args   : lsqr_t *lsq      I   least square accumulator
+ *          double *dx       O   estimated parameters (nx x 1)
+ *          double *Q        O   estimated parameters covariance matrix (nx x nx)
+ * return : status (0:ok,-1:rank deficient)
+ * notes  : dx=R^-1*z, Q=R^-1*R^-1'
+ *-----------------------------------------------------------------------------*/
+static int solve_lsqr(const lsqr_t *lsq, double *dx, double *Q)
+{
+    const double *R = lsq->R;
+    double s;
+    int i, j, k, nx = lsq->nx;
+
+    for (i = 0; i < nx; i++)
+    {
+        if (R[i + i * nx] == 0.0)
+            return -1;
+    }
+    for (i = nx - 1; i >= 0; i--)
+    {
+        s = lsq->z[i];
+        for (k = i + 1; k < nx; k++)
+            s -= R[i + k * nx] * dx[k];
+        dx[i] = s / R[i + i * nx];
+    }
+    /* R^-1 (upper triangle of Q) */
+    for (j = 0; j < nx; j++)
+    {
+        Q[j + j * nx] = 1.0 / R[j + j * nx];
+        for (i = j - 1; i >= 0; i--)
+        {
+            s = 0.0;
+            for (k = i + 1; k <= j; k++)
+                s -= R[i + k * nx] * Q[k + j * nx];
+            Q[i + j * nx] = s / R[i + i * nx];
+        }
+    }
+    /* R^-1*R^-1' (lower triangle, then mirrored) */
+    for (i = 0; i < nx; i++)
+    {
+        for (j = 0; j <= i; j++)
+        {
+            s = 0.0;
+            for (k = i; k < nx; k++)
+                s += Q[j + k * nx] * Q[i + k * nx];
+            Q[i + j * nx] = s;
+        }
+    }
+    for (i = 0; i < nx; i++)
+    {
+        for (j = i + 1; j < nx; j++)
+            Q[i + j * nx] = Q[j + i * nx];
+    }
+    return 0;
+}
 /* pseudorange residuals -----------------------------------------------------*/
 /**
  * @brief 计算在当前接收机位置和钟差值的情况下，
- *          定位方程的右端部分 v(nv\*1)
- *          几何矩阵 H(NX*nv)
- *          此时所得的伪距残余的方差 var
+ *          定位方程每一行的伪距残余 v、几何矩阵行 h和伪距残余的方差 var，
+ *          逐行加入最小二乘累加器 lsq
  *          所有观测卫星的 azel{方位角、仰角}
  *          定位时有效性 vsat
  *          定位后伪距残差 resp
  *          参与定位的卫星个数 ns和方程个数 nv。
  *
- * 函数参数，17个
+ * 各卫星的仰角、伪距、电离层和对流层延时及误差方差在改正数表 corr中每历元计算一次，
+ * 仅当迭代阶段改变或接收机位置变化超过 corr->drmax时重新计算，每次迭代只重新计算几何距离、视线向量
+ * 和天顶对流层延时 (各卫星的对流层延时按天顶延时之比缩放，以计入高程的变化)。
+ * 位置变化使当地垂线倾斜 |dr|/RE，低仰角卫星的斜路径对流层延时变化 zd*cos(el)/sin(el)^2*|dr|/RE，
+ * 所以 corr->drmax取 MAXDRCORR和此变化不超过 MAXDTRCORR的位置变化中的较小者 (按最低仰角)。
+ *
+ * 函数参数，18个
  * int      iter      I    迭代次数
  * obsd_t   *obs      I    observation data
  * int      n         I    number of observation data
  * double   *rs       I   satellite positions and velocities，长度为6*n，{x,y,z,vx,vy,vz}(ecef)(m,m/s)
  * double   *dts      I   satellite clocks，长度为2*n， {bias,drift} (s|s/s)
  * double   *vare     I   sat position and clock error variances (m^2)
- * int      *svh      I   sat health flag (-1:correction not available)
+ * int      *svh      I   sat health flag (-1:correction not available or excluded)
  * nav_t    *nav      I   navigation data
  * double   *x        I   本次迭代开始之前的定位值
  * prcopt_t *opt      I   processing options
- * double   *v        O   定位方程的右端部分，伪距残余
- * double   *H        O   定位方程中的几何矩阵
- * double   *var      O   参与定位的伪距残余方差
- * double   *azel     O   对于当前定位值，每一颗观测卫星的 {方位角、高度角}
+ * corr_t   *corr     IO  本历元的卫星改正数表 (corr->iter=-1: 未计算)
+ * lsqr_t   *lsq      IO  最小二乘累加器（加入定位方程各行）
+ * double   *azel     IO  对于改正数表的接收机位置，每一颗观测卫星的 {方位角、高度角}
  * int      *vsat     O   每一颗观测卫星在当前定位时是否有效
  * double   *resp     O   每一颗观测卫星的伪距残余， (P-(r+c*dtr-c*dts+I+T))
  * int      *ns       O   参与定位的卫星的个数
+ * double   *varp     O   每一颗观测卫星的伪距残余方差 (m^2) (NULL: no output)
  * 返回类型：
  * int                O   定位方程组的方程个数
  */
 static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
                    const double *dts, const double *vare, const int *svh,
                    const nav_t *nav, const double *x, const prcopt_t *opt,
-                   double *v, double *H, double *var, double *azel, int *vsat,
-                   double *resp, int *ns)
+                   corr_t *corr, lsqr_t *lsq, double *azel, int *vsat, double *resp,
+                   int *ns, double *varp)
 {
-    double r, dion, dtrp, vmeas, vion, vtrp, rr[3], pos[3], dtr, e[3], P, lam_L1;
-    int i, j, nv = 0, sys, mask[4] = {0};
+    const double azel_z[] = {0.0, PI / 2.0};
+    double r, dion, dtrp, vmeas, vion, vtrp, rr[3], pos[3], dtr, e[3], P, lam_L1, dr[3];
+    double v, h[NX], var, zd, ztrp = 1.0, drc;
+    int i, j, nv = 0, sys, upd, mask[4] = {0};
 
     // trace(3,"resprng : n=%d\n",n);
     //* 1、将之前得到的定位解信息赋值给rr和dtr数组，以进行关于当前解的伪距残余的相关计算。
@@ -324,14 +465,39 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
         rr[i] = x[i];
     dtr = x[3];
 
-    //* 2、将得到的ecef位置信息转换为大地坐标系信息
+    //* 2、将得到的ecef位置信息转换为大地坐标系信息，计算天顶对流层延时。
+    //*     改正数表未计算、迭代阶段 (首次/其后) 改变或接收机位置变化超过 MAXDRCORR时，重新计算改正数表，
+    //*     否则由天顶延时之比 ztrp缩放表中的对流层延时。
     ecef2pos(rr, pos);
+    zd = tropmodel(obs[0].time, pos, azel_z, REL_HUMI);
 
+    if (!(upd = corr->iter != (iter > 0)))
+    {
+        for (i = 0; i < 3; i++)
+            dr[i] = rr[i] - corr->rr[i];
+        upd = norm(dr, 3) > corr->drmax;
+    }
+    if (upd)
+    {
+        corr->iter = iter > 0;
+        corr->zd = zd;
+        corr->drmax = MAXDRCORR;
+        for (i = 0; i < 3; i++)
+            corr->rr[i] = rr[i];
+    }
+    else if (corr->zd > 0.0)
+        ztrp = zd / corr->zd;
     for (i = *ns = 0; i < n && i < MAXOBS; i++)
     {
-        //* 3、将 vsat、azel和 resp数组置 0，因为在前后两次定位结果中，每颗卫星的上述信息都会发生变化。
+        //* 3、将 vsat和 resp数组置 0，因为在前后两次定位结果中，每颗卫星的上述信息都会发生变化。
+        //*     重新计算改正数表时 azel和改正数也置 0。
         vsat[i] = 0;
-        azel[i * 2] = azel[1 + i * 2] = resp[i] = 0.0;
+        resp[i] = 0.0;
+        if (upd)
+        {
+            azel[i * 2] = azel[1 + i * 2] = 0.0;
+            corr->P[i] = 0.0;
+        }
         //* 4、调用 satsys函数，验证卫星编号是否合理及其所属的导航系统。
         if (!(sys = satsys(obs[i].sat, NULL)))
             continue;
@@ -345,94 +511,125 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
             i++;
             continue;
         }
-        /* geometric distance/azimuth/elevation angle */
+        /* geometric distance */
         //* 6、计算卫星和当前接收机位置之间的几何距离和 receiver-to-satellite方向的单位向量。然后检验几何距离是否 >0。
-        if ((r = geodist(rs + i * 6, rr, e)) <= 0.0 ||
-            satazel(pos, e, azel + i * 2) < opt->elmin) //* 7、调用 satazel函数，计算在接收机位置处的站心坐标系中卫星的方位角和仰角，检验仰角是否≥截断值。
+        if ((r = geodist(rs + i * 6, rr, e)) <= 0.0)
             continue;
 
-        /* psudo range with code bias correction */
-        //* 8、计算伪距值。
-        if ((P = prange(obs + i, nav, azel + i * 2, iter, opt, &vmeas)) == 0.0)
+        if (upd)
+        {
+            /* azimuth/elevation angle */
+            //* 7、调用 satazel函数，计算在接收机位置处的站心坐标系中卫星的方位角和仰角，检验仰角是否≥截断值。
+            if (satazel(pos, e, azel + i * 2) < opt->elmin)
+                continue;
+
+            /* psudo range with code bias correction */
+            //* 8、计算伪距值。
+            if ((P = prange(obs + i, nav, azel + i * 2, iter, opt, &vmeas)) == 0.0)
+                continue;
+
+            /* ionospheric corrections */
+            //* 9、计算电离层延时(m)已经转换为m的单位
+            if (!ionocorr(obs[i].time, nav, obs[i].sat, pos, azel + i * 2,
+                          iter > 0 ? opt->ionoopt : IONOOPT_BRDC, &dion, &vion))
+                continue;
+
+            /* GPS-L1 -> L1/B1 */
+            //* 10、9中所得的电离层延时是建立在 L1信号上的，当使用其它频率信号时，
+            //*     依据所用信号频组中第一个频率的波长与 L1波长的关系，对上一步得到的电离层延时进行修正。
+            if ((lam_L1 = nav->lam[obs[i].sat - 1][0]) > 0.0)
+            {
+                dion *= SQR(lam_L1 / lam_carr[0]);
+            }
+            /* tropospheric corrections */
+            //* 11、计算对流层延时(m)
+            if (!tropcorr(obs[i].time, nav, pos, azel + i * 2,
+                          iter > 0 ? opt->tropopt : TROPOPT_SAAS, &dtrp, &vtrp))
+            {
+                continue;
+            }
+            /* error variance */
+            //* 12、调用 varerr函数，计算此时的导航系统误差（可能会包括 IFLC选项时的电离层延时），
+            //*     与伪距、电离层和对流层延时的方差一起存入改正数表。
+            corr->P[i] = P - dion;
+            corr->trp[i] = dtrp;
+            corr->var[i] = varerr(opt, azel[1 + i * 2], sys) + vmeas + vion + vtrp;
+
+            /* max position change to reuse slant delay at elevation */
+            if (zd > 0.0)
+            {
+                drc = MAXDTRCORR * RE_WGS84 * SQR(sin(azel[1 + i * 2])) / (zd * cos(azel[1 + i * 2]));
+                if (drc < corr->drmax)
+                    corr->drmax = drc;
+            }
+        }
+        if (corr->P[i] == 0.0)
             continue;
 
         /* excluded satellite? */
-        //* 9、可以在处理选项中事先指定只选用哪些导航系统或卫星来进行定位，这是通过调用satexclude函数完成的。
+        //* 13、可以在处理选项中事先指定只选用哪些导航系统或卫星来进行定位，这是通过调用satexclude函数完成的。
+        //*     svh<0 (无星历或被 RAIM排除)的卫星不参与定位。
         //        if (satexclude(obs[i].sat,svh[i],opt)) continue;
-
-        /* ionospheric corrections */
-        //* 10、计算电离层延时(m)已经转换为m的单位
-        if (!ionocorr(obs[i].time, nav, obs[i].sat, pos, azel + i * 2,
-                      iter > 0 ? opt->ionoopt : IONOOPT_BRDC, &dion, &vion))
+        if (svh[i] < 0)
             continue;
 
-        /* GPS-L1 -> L1/B1 */
-        //* 11、10中所得的电离层延时是建立在 L1信号上的，当使用其它频率信号时，
-        //*     依据所用信号频组中第一个频率的波长与 L1波长的关系，对上一步得到的电离层延时进行修正。
-        if ((lam_L1 = nav->lam[obs[i].sat - 1][0]) > 0.0)
-        {
-            dion *= SQR(lam_L1 / lam_carr[0]);
-        }
-        /* tropospheric corrections */
-        //* 12、计算对流层延时(m)
-        if (!tropcorr(obs[i].time, nav, pos, azel + i * 2,
-                      iter > 0 ? opt->tropopt : TROPOPT_SAAS, &dtrp, &vtrp))
-        {
-            continue;
-        }
         /* pseudorange residual */
-        //* 13、计算伪距残差
-        v[nv] = P - (r + dtr - CLIGHT * dts[i * 2] + dion + dtrp);
+        //* 14、计算伪距残差
+        v = corr->P[i] - (r + dtr - CLIGHT * dts[i * 2] + corr->trp[i] * ztrp);
 
         /* design matrix */
-        //* 14、组装几何矩阵，前 3行为 6中计算得到的视线单位向量的反向，第 4行为 1，其它行为 0。
+        //* 15、组装几何矩阵行，前 3列为 6中计算得到的视线单位向量的反向，第 4列为 1，其它列为 0。
         for (j = 0; j < NX; j++)
-            H[j + nv * NX] = j < 3 ? -e[j] : (j == 3 ? 1.0 : 0.0);
+            h[j] = j < 3 ? -e[j] : (j == 3 ? 1.0 : 0.0);
 
         /* time system and receiver bias offset correction */
         if (sys == SYS_GLO)
         {
-            v[nv] -= x[4];
-            H[4 + nv * NX] = 1.0;
+            v -= x[4];
+            h[4] = 1.0;
             mask[1] = 1;
         }
         else if (sys == SYS_GAL)
         {
-            v[nv] -= x[5];
-            H[5 + nv * NX] = 1.0;
+            v -= x[5];
+            h[5] = 1.0;
             mask[2] = 1;
         }
         else if (sys == SYS_CMP)
         {
-            v[nv] -= x[6];
-            H[6 + nv * NX] = 1.0;
+            v -= x[6];
+            h[6] = 1.0;
             mask[3] = 1;
         }
         else
             mask[0] = 1;
 
-        //* 15、将参与定位的卫星的定位有效性标志设为1，给当前卫星的伪距残余赋值，参与定位的卫星个数 ns加 1.
+        //* 16、将参与定位的卫星的定位有效性标志设为1，给当前卫星的伪距残余赋值，参与定位的卫星个数 ns加 1.
         vsat[i] = 1;
-        resp[i] = v[nv];
+        resp[i] = v;
         (*ns)++;
 
         /* error variance */
-        //* 16、调用 varerr函数，计算此时的导航系统误差（可能会包括 IFLC选项时的电离层延时），然后累加计算用户测距误差(URE)。
-        var[nv++] = varerr(opt, azel[1 + i * 2], sys) + vare[i] + vmeas + vion + vtrp;
+        //* 17、累加卫星位置和钟差的方差得到用户测距误差(URE)，以方差的倒数为权，将该行加入最小二乘累加器。
+        var = corr->var[i] + vare[i];
+        addrow_lsqr(lsq, h, v, var);
+        if (varp)
+            varp[i] = var;
+        nv++;
 
         //        trace(4,"sat=%2d azel=%5.1f %4.1f res=%7.3f sig=%5.3f\n",obs[i].sat,
         //              azel[i*2]*R2D,azel[1+i*2]*R2D,resp[i],sqrt(var[nv-1]));
     }
     /* constraint to avoid rank-deficient */
-    //* 17、为了防止亏秩，人为的添加了几组观测方程。
+    //* 18、为了防止亏秩，人为的添加了几组观测方程。
     for (i = 0; i < 4; i++)
     {
         if (mask[i])
             continue;
-        v[nv] = 0.0;
         for (j = 0; j < NX; j++)
-            H[j + nv * NX] = j == i + 3 ? 1.0 : 0.0;
-        var[nv++] = 0.01;
+            h[j] = j == i + 3 ? 1.0 : 0.0;
+        addrow_lsqr(lsq, h, 0.0, 0.01);
+        nv++;
     }
     return nv;
 }
@@ -444,7 +641,7 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
  * int      *vsat     I   表征卫星在定位时是否有效
  * int      n         I   number of observation data
  * prcopt_t *opt      I   processing options
- * double   *v        I   定位后伪距残差 (P-(r+c*dtr-c*dts+I+T))
+ * double   vv        I   加权伪距残差平方和
  * int      nv        I   定位方程的方程个数
  * int      nx        I   未知数的个数
  * char     *msg      O   error message for error exit
@@ -452,25 +649,23 @@ static int rescode(int iter, const obsd_t *obs, int n, const double *rs,
  * int                O    (1:ok,0:error)
  */
 static int valsol(const double *azel, const int *vsat, int n,
-                  const prcopt_t *opt, const double *v, int nv, int nx,
+                  const prcopt_t *opt, double vv, int nv, int nx,
                   char *msg)
 {
-    double azels[MAXOBS * 2], dop[4], vv;
+    double azels[MAXOBS * 2], dop[4];
     int i, ns;
 
     // trace(3,"valsol  : n=%d nv=%d\n",n,nv);
 
     /* chi-square validation of residuals */
-    //* 1、计算定位后伪距残差平方加权和和vv
-    vv = dot(v, v, nv);
-    //* 2、卡方检测，定位误差是否过大
+    //* 1、卡方检测，定位误差是否过大
     if (nv > nx && vv > chisqr[nv - nx - 1])
     {
         sprintf(msg, "chi-square error nv=%d vv=%.1f cs=%.1f", nv, vv, chisqr[nv - nx - 1]);
         return 0;
     }
     /* large gdop check */
-    //* 3、复制azel，这里只复制那些对于定位结果有贡献的卫星的 zael值，并且统计实现定位时所用卫星的数目。
+    //* 2、复制azel，这里只复制那些对于定位结果有贡献的卫星的 zael值，并且统计实现定位时所用卫星的数目。
     for (i = ns = 0; i < n; i++)
     {
         if (!vsat[i])
@@ -479,7 +674,7 @@ static int valsol(const double *azel, const int *vsat, int n,
         azels[1 + ns * 2] = azel[1 + i * 2];
         ns++;
     }
-    //* 4、调用 dops函数，计算各种精度因子(DOP)，检验是否有 0<GDOP<max。
+    //* 3、调用 dops函数，计算各种精度因子(DOP)，检验是否有 0<GDOP<max。
     //*     否，则说明该定位解的精度不符合要求，返回 0；是，则返回 1。
     dops(ns, azels, opt->elmin, dop);
     if (dop[0] <= 0.0 || dop[0] > opt->maxgdop)
@@ -489,6 +684,35 @@ static int valsol(const double *azel, const int *vsat, int n,
     }
     return 1;
 }
+/* predict initial state -----------------------------------------------------*/
+/**
+ * @brief 由上一历元的解外推本历元定位的初始状态 (warm start)：
+ *        位置按速度、钟差按钟漂外推，系统间偏差沿用上一历元的值。
+ *        上一历元无解或间隔过大时位置取上一历元的值，钟差和系统间偏差置 0 (cold start)。
+ * gtime_t  time      I   本历元观测时刻 (接收机时)
+ * sol_t    *sol      IO  上一历元的解 -> 本历元的初始状态 (sol->rr, sol->dtr)
+ * 返回类型:
+ * int                O     (1:warm start,0:cold start)
+ */
+static int predsol(gtime_t time, sol_t *sol)
+{
+    double tt;
+    int i;
+
+    //* 上一历元的观测时刻 = 解的时刻 (gpst) + 接收机钟差
+    tt = timediff(time, timeadd(sol->time, sol->dtr[0]));
+
+    if (sol->stat == SOLQ_NONE || fabs(tt) > MAXTTWARM)
+    {
+        for (i = 0; i < 4; i++)
+            sol->dtr[i] = 0.0;
+        return 0;
+    }
+    for (i = 0; i < 3; i++)
+        sol->rr[i] += sol->rr[i + 3] * tt;
+    sol->dtr[0] += sol->dtr[5] * tt;
+    return 1;
+}
 /* estimate receiver position ------------------------------------------------*/
 /**
  * @brief 通过伪距实现绝对定位，计算出接收机的位置和钟差，
@@ -502,7 +726,9 @@ static int valsol(const double *azel, const int *vsat, int n,
  * int      *svh      I   sat health flag (-1:correction not available)
  * nav_t    *nav      I   navigation data
  * prcopt_t *opt      I   processing options
- * sol_t    *sol      IO  solution
+ * int      warm      I   初始状态由上一历元的解预测 (1:warm start,0:cold start)
+ * corr_t   *corr     IO  本历元的卫星改正数表
+ * sol_t    *sol      IO  solution (初始状态 sol->rr, sol->dtr; sol->niter: 累加迭代次数)
  * double   *azel     IO  azimuth/elevation angle (rad)
  * int      *vsat     IO  表征卫星在定位时是否有效
  * double   *resp     IO  定位后伪距残差 (P-(r+c*dtr-c*dts+I+T))
@@ -512,68 +738,63 @@ static int valsol(const double *azel, const int *vsat, int n,
  */
 static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
                   const double *vare, const int *svh, const nav_t *nav,
-                  const prcopt_t *opt, sol_t *sol, double *azel, int *vsat,
-                  double *resp, char *msg)
+                  const prcopt_t *opt, int warm, corr_t *corr, sol_t *sol, double *azel,
+                  int *vsat, double *resp, char *msg)
 {
-    double x[NX] = {0}, dx[NX], Q[NX * NX], sig;
-    int i, j, k, info, stat, nv, ns;
+    lsqr_t lsq;
+    double x[NX], dx[NX], Q[NX * NX], dxn, dxp = 0.0;
+    int i, j, info, stat, nv, ns;
 
     // trace(3,"estpos  : n=%d\n",n);
-    double H[(MAXOBS + 4)], v[7 * (MAXOBS + 4)], var[MAXOBS + 4];
-    //    v=mat(n+4,1); H=mat(NX,n+4); var=mat(n+4,1);
 
-    //* 1、将 sol->rr的前 3项赋值给 x数组
+    //* 1、将 sol->rr的前 3项和 sol->dtr的前 4项 (钟差、系统间偏差) 赋值给 x数组
     for (i = 0; i < 3; i++)
         x[i] = sol->rr[i];
+    for (i = 0; i < 4; i++)
+        x[i + 3] = sol->dtr[i] * CLIGHT;
 
     //* 2、开始迭代，最大迭代10次，用的是梯度下降方法求解最小二乘
     for (i = 0; i < MAXITR; i++)
     {
+        sol->niter++;
 
         /* pseudo range residuals */
         //* 首先调用 rescode函数，计算在当前接收机位置和钟差值的情况下，
-        //*     定位方程的右端部分 v(nv\*1)、几何矩阵 H(NX*nv)、
+        //*     定位方程的各行（伪距残余 v、几何矩阵行 h、方差 var），逐行加入最小二乘累加器 lsq，
         //*     此时所得的
-        //*             伪距残余的方差 var
         //*             所有观测卫星的 azel{方位角、仰角}
         //*             定位时有效性 vsat
         //*             定位后伪距残差 resp
         //*             参与定位的卫星个数 ns和方程个数 nv。
-        nv = rescode(i, obs, n, rs, dts, vare, svh, nav, x, opt, v, H, var, azel, vsat, resp,
-                     &ns);
+        //*     warm start时初始位置已接近真值，第一次迭代即使用 snr掩码和设定的电离层、对流层模型。
+        init_lsqr(&lsq, NX);
+        nv = rescode(warm ? i + 1 : i, obs, n, rs, dts, vare, svh, nav, x, opt, corr, &lsq,
+                     azel, vsat, resp, &ns, NULL);
         //* 3、确定方程组中方程的个数要大于未知数的个数。
         if (nv < NX)
         {
             sprintf(msg, "lack of valid sats ns=%d", nv);
             break;
         }
-        /* weight by variance */
-        //* 4、以伪距残余的标准差的倒数作为权重，
-        //*     对 H和 v分别左乘权重对角阵，得到加权之后的 H和 v。
-        for (j = 0; j < nv; j++)
-        {
-            sig = sqrt(var[j]);
-            v[j] /= sig;
-            for (k = 0; k < NX; k++)
-                H[k + j * NX] /= sig;
-        }
-        /* least square estimation */
-        //* 5、调用 lsq函数，根据 Δx = (HH')^-1Hv和Q = (HH')^-1，
-        //*     得到当前 x的修改量和定位误差协方差矩阵中的权系数阵。
-        if ((info = lsq(H, v, NX, nv, dx, Q)))
+        /* weighted least square estimation */
+        //* 4、调用 solve_lsqr函数，由累加器中的三角阵 R（HWH' = R'R）得到 Δx = R^-1z和Q = (R'R)^-1，
+        //*     即当前 x的修改量和定位误差协方差矩阵中的权系数阵。
+        if ((info = solve_lsqr(&lsq, dx, Q)))
         {
             sprintf(msg, "lsq error info=%d", info);
             break;
         }
-        //* 6、将5中求得的x加入到当前x值中，得到更新之后的x值。
+        //* 5、将4中求得的x加入到当前x值中，得到更新之后的x值。
         for (j = 0; j < NX; j++)
             x[j] += dx[j];
 
-        //* 7、如果 5中求得的修改量小于截断因子(目前是1e-4)，
-        //*     则将 6中得到的 x值作为最终的定位结果，对 sol的相应参数赋值，
+        //* 6、如果 4中求得的修改量小于截断因子(目前是1e-4)，或修改量已小于 MAXDXCONV且由相邻两次修改量之比
+        //*     (收敛速率) 估计的下一次修改量小于截断因子 (初值接近真值时可省去最后一次迭代)，
+        //*     则将 5中得到的 x值作为最终的定位结果，对 sol的相应参数赋值，
         //*     之后再调用 valsol函数确认当前解是否符合要求（伪距残余小于某个 值和 GDOP小于某个门限值）。
         //*     否则，进行下一次循环。
-        if (norm(dx, NX) < 1E-4)
+        dxn = norm(dx, NX);
+        if (dxn < 1E-4 || (i > 0 && dxn < MAXDXCONV && dxn * dxn / dxp < 1E-4))
         {
             sol->type = 0;
             sol->time = timeadd(obs[0].time, -x[3] / CLIGHT);
@@ -581,6 +802,7 @@ static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
             sol->dtr[1] = x[4] / CLIGHT; /* glo-gps time offset (s) */
             sol->dtr[2] = x[5] / CLIGHT; /* gal-gps time offset (s) */
             sol->dtr[3] = x[6] / CLIGHT; /* bds-gps time offset (s) */
+            sol->dtr[5] = 0.0;           /* receiver clock drift (s/s) (estvel) */
             for (j = 0; j < 6; j++)
                 sol->rr[j] = j < 3 ? x[j] : 0.0;
             for (j = 0; j < 3; j++)
@@ -590,11 +812,12 @@ static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
             sol->qr[5] = (float)Q[2];      /* cov zx */
             sol->ns = (unsigned char)ns;
             sol->age = sol->ratio = 0.0;
+            sol->chisq = (float)lsq.vv;
 
             /* validate solution */
             //! 如果某次迭代过程中步长小于门限值(1e-4)，但经 valsol函数检验后该解无效，
             //!     则会直接返回 0，并不会再进行下一次迭代计算。
-            if ((stat = valsol(azel, vsat, n, opt, v, nv, NX, msg)))
+            if ((stat = valsol(azel, vsat, n, opt, lsq.vv, nv, NX, msg)))
             {
                 sol->stat = opt->sateph == EPHOPT_SBAS ? SOLQ_SBAS : SOLQ_SINGLE;
             }
@@ -602,8 +825,9 @@ static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
 
             return stat;
         }
+        dxp = dxn;
     }
-    //* 8、如果超过了规定的循环次数，则输出发散信息后，返回 0。
+    //* 7、如果超过了规定的循环次数，则输出发散信息后，返回 0。
     if (i >= MAXITR)
         sprintf(msg, "iteration divergent i=%d", i);
 
@@ -613,7 +837,10 @@ static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
 }
 /* raim fde (failure detection and exclution) -------------------------------*/
 /**
- * 函数参数，13个：
+ * @brief 由未通过检验的收敛解的残差和投影矩阵进行故障检测与排除：
+ *        计算每颗卫星的标准化残差 (w检验)，对最大者以秩1降阶 (downdate)
+ *        检验排除后的卡方值，通过则排除该卫星并重新解算一次确认。
+ * 函数参数，14个：
  * obsd_t   *obs      I   observation data
  * int      n         I   number of observation data
  * double   *rs       I   satellite positions and velocities，长度为6*n，{x,y,z,vx,vy,vz}(ecef)(m,m/s)
@@ -622,7 +849,8 @@ static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
  * int      *svh      I   sat health flag (-1:correction not available)
  * nav_t    *nav      I   navigation data
  * prcopt_t *opt      I   processing options
- * sol_t    *sol      IO  solution
+ * corr_t   *corr     IO  本历元的卫星改正数表
+ * sol_t    *sol      IO  solution (sol->wtest: 最大标准化残差, sol->exsat: 排除的卫星)
  * double   *azel     IO  azimuth/elevation angle (rad)
  * int      *vsat     IO  表征卫星在定位时是否有效
  * double   *resp     IO  定位后伪距残差 (P-(r+c*dtr-c*dts+I+T))
@@ -632,102 +860,92 @@ static int estpos(const obsd_t *obs, int n, const double *rs, const double *dts,
  */
 static int raim_fde(const obsd_t *obs, int n, const double *rs,
                     const double *dts, const double *vare, const int *svh,
-                    const nav_t *nav, const prcopt_t *opt, sol_t *sol,
+                    const nav_t *nav, const prcopt_t *opt, corr_t *corr, sol_t *sol,
                     double *azel, int *vsat, double *resp, char *msg)
 {
-    obsd_t obs_e[sizeof(obsd_t) * MAXOBS];
-    sol_t sol_e = {{0}};
-    char tstr[32], name[16], msg_e[128];
-    double rs_e[6 * MAXOBS], dts_e[2 * MAXOBS], vare_e[1 * MAXOBS], azel_e[2 * MAXOBS], resp_e[1 * MAXOBS], rms_e, rms = 100.0;
-    int i, j, k, nvsat, stat = 0, svh_e[1 * MAXOBS], vsat_e[1 * MAXOBS], sat = 0;
+    lsqr_t lsq;
+    double x[NX], dx[NX], Q[NX * NX], varp[MAXOBS], a[NX], qa[NX], e[3];
+    double sig, r, p, t, rex = 0.0, pex = 1.0, rss;
+    int i, j, k, nv, ns, sys, iex = -1, svh_e[MAXOBS];
 
     // trace(3,"raim_fde: %s n=%2d\n",time_str(obs[0].time,0),n);
-    //    if (!(obs_e=(obsd_t *)malloc(sizeof(obsd_t)*n))) return 0;
-    //    rs_e = mat(6,n); dts_e = mat(2,n); vare_e=mat(1,n); azel_e=zeros(2,n);
-    //    svh_e=imat(1,n); vsat_e=imat(1,n); resp_e=mat(1,n);
-    //* 1、关于观测卫星数目的循环，每次舍弃一颗卫星，计算使用余下卫星进行定位的定位值。
-    for (i = 0; i < n; i++)
-    {
-
-        /* satellite exclution */
-        for (j = k = 0; j < n; j++)
-        {
-            if (j == i)
-                continue;
-            obs_e[k] = obs[j];
-            matcpy(rs_e + 6 * k, rs + 6 * j, 6, 1);
-            matcpy(dts_e + 2 * k, dts + 2 * j, 2, 1);
-            vare_e[k] = vare[j];
-            svh_e[k++] = svh[j];
-        }
-        /* estimate receiver position without a satellite */
-        //* 2、舍弃一颗卫星后，将剩下卫星的数据复制到一起，调用 estpos函数，计算使用余下卫星进行定位的定位值。
-        if (!estpos(obs_e, n - 1, rs_e, dts_e, vare_e, svh_e, nav, opt, &sol_e, azel_e,
-                    vsat_e, resp_e, msg_e))
-        {
-            // trace(3,"raim_fde: exsat=%2d (%s)\n",obs[i].sat,msg);
-            continue;
-        }
-        //* 3、累加使用当前卫星实现定位后的伪距残差平方和与可用微信数目
-        for (j = nvsat = 0, rms_e = 0.0; j < n - 1; j++)
-        {
-            if (!vsat_e[j])
-                continue;
-            rms_e += SQR(resp_e[j]);
-            nvsat++;
-        }
-        //* 如果 nvsat<5，则说明当前卫星数目过少，无法进行 RAIM_FDE操作。
-        if (nvsat < 5)
-        {
-            //            trace(3,"raim_fde: exsat=%2d lack of satellites nvsat=%2d\n",
-            //                  obs[i].sat,nvsat);
-            continue;
-        }
-        //* 4、计算伪距残差平方和的标准平均值
-        rms_e = sqrt(rms_e / nvsat);
-
-        //        trace(3,"raim_fde: exsat=%2d rms=%8.3f\n",obs[i].sat,rms_e);
 
-        if (rms_e > rms)
+    //* 1、在 estpos得到的解处重新计算一次伪距残差和最小二乘解，
+    //*     只有解已经收敛 (Δx很小) 时才能由残差检测故障。
+    for (i = 0; i < 3; i++)
+        x[i] = sol->rr[i];
+    for (i = 0; i < 4; i++)
+        x[i + 3] = sol->dtr[i] * CLIGHT;
+    init_lsqr(&lsq, NX);
+    nv = rescode(1, obs, n, rs, dts, vare, svh, nav, x, opt, corr, &lsq, azel, vsat, resp,
+                 &ns, varp);
+    if (ns < 6 || nv <= NX + 1)
+    {
+        sprintf(msg, "raim lack of satellites ns=%d", ns);
+        return 0;
+    }
+    if (solve_lsqr(&lsq, dx, Q) || norm(dx, NX) > MAXDXRAIM)
+    {
+        sprintf(msg, "raim solution not converged");
+        return 0;
+    }
+    //* 2、对每颗卫星计算加权设计矩阵行 a、验后残差 r和多余观测分量 p=1-a'Qa，
+    //*     标准化残差 |r|/sqrt(p) 最大的卫星为故障卫星。
+    for (i = 0; i < n && i < MAXOBS; i++)
+    {
+        if (!vsat[i])
             continue;
+        sys = satsys(obs[i].sat, NULL);
+        geodist(rs + i * 6, x, e);
+        sig = sqrt(varp[i]);
+        for (j = 0; j < NX; j++)
+            a[j] = (j < 3 ? -e[j] : (j == 3 ? 1.0 : 0.0)) / sig;
+        if (sys == SYS_GLO)
+            a[4] = 1.0 / sig;
+        else if (sys == SYS_GAL)
+            a[5] = 1.0 / sig;
+        else if (sys == SYS_CMP)
+            a[6] = 1.0 / sig;
 
-        /* save result */
-        //*     如果小于 rms，则说明当前定位结果更合理，
-        //*     将 stat置为 1，重新更新 sol、azel、vsat(当前被舍弃的卫星，此值置为0)、resp等值
-        //*     并将当前的 rms_e更新到 `rms'中。
-        for (j = k = 0; j < n; j++)
+        r = resp[i] / sig - dot(a, dx, NX);
+        for (j = 0; j < NX; j++)
         {
-            if (j == i)
-                continue;
-            matcpy(azel + 2 * j, azel_e + 2 * k, 2, 1);
-            vsat[j] = vsat_e[k];
-            resp[j] = resp_e[k++];
+            for (qa[j] = 0.0, k = 0; k < NX; k++)
+                qa[j] += Q[j + k * NX] * a[k];
         }
-        stat = 1;
-        *sol = sol_e;
-        sat = obs[i].sat;
-        rms = rms_e;
-        vsat[i] = 0;
-        strcpy(msg, msg_e);
+        if ((p = 1.0 - dot(a, qa, NX)) < 1E-6)
+            continue; /* no redundancy */
+        if ((t = fabs(r) / sqrt(p)) <= sol->wtest)
+            continue;
+        sol->wtest = (float)t;
+        iex = i;
+        rex = r;
+        pex = p;
     }
-    //* 6、如果 stat不为 0，则说明在弃用卫星的前提下有更好的解出现，输出信息，指出弃用了哪科卫星。
-    if (stat)
+    if (iex < 0)
+        return 0;
+
+    //* 3、以秩1降阶得到排除该卫星后的验后残差平方和 rss-r^2/p，进行卡方检验。
+    rss = lsq.rss - rex * rex / pex;
+    if (rss > chisqr[nv - NX - 2])
     {
-        time2str(obs[0].time, tstr, 2);
-        satno2id(sat, name);
-        //        trace(2,"%s: %s excluded by raim\n",tstr+11,name);
+        sprintf(msg, "raim fault not isolated sat=%d wtest=%.1f", obs[iex].sat, sol->wtest);
+        return 0;
     }
+    //* 4、排除该卫星 (svh=-1) 后重新解算一次确认。
+    for (i = 0; i < n && i < MAXOBS; i++)
+        svh_e[i] = i == iex ? -1 : svh[i];
 
-    //* 5、继续弃用下一颗卫星，重复 2-4操作。总而言之，将同样是弃用一颗卫星条件下，
-    //*     伪距残差标准平均值最小的组合所得的结果作为最终的结果输出。
-    //    free(obs_e);
-    //    free(rs_e ); free(dts_e ); free(vare_e); free(azel_e);
-    //    free(svh_e); free(vsat_e); free(resp_e);
-    return stat;
+    if (!estpos(obs, n, rs, dts, vare, svh_e, nav, opt, 1, corr, sol, azel, vsat, resp, msg))
+        return 0;
+
+    sol->exsat = (uint8_t)obs[iex].sat;
+    // trace(2,"%s: sat=%2d excluded by raim\n",time_str(obs[0].time,0),obs[iex].sat);
+    return 1;
 }
 /* doppler residuals ---------------------------------------------------------*/
 /**
- * @brief 计算定速方程组左边的几何矩阵和右端的速度残余，返回定速时所使用的卫星数目
+ * @brief 计算定速方程组各行的几何矩阵行和速度残余，逐行加入最小二乘累加器，返回定速时所使用的卫星数目
  * 函数参数，11个：
  * obsd_t   *obs      I   observation data
  * int      n         I   number of observation data
@@ -738,16 +956,15 @@ static int raim_fde(const obsd_t *obs, int n, const double *rs,
  * double   *x        I   本次迭代开始之前的定速值
  * double   *azel     I   azimuth/elevation angle (rad)
  * int      *vsat     I   表征卫星在定速时是否有效
- * double   *v        O   定速方程的右端部分，速度残余
- * double   *H        O   定速方程中的几何矩阵
+ * lsqr_t   *lsq      IO  最小二乘累加器（加入定速方程各行，权为 1）
  * 返回类型:
  * int                O    定速时所使用的卫星数目
  */
 static int resdop(const obsd_t *obs, int n, const double *rs, const double *dts,
                   const nav_t *nav, const double *rr, const double *x,
-                  const double *azel, const int *vsat, double *v, double *H)
+                  const double *azel, const int *vsat, lsqr_t *lsq)
 {
-    double lam, rate, pos[3], E[9], a[3], e[3], vs[3], cosel;
+    double lam, rate, pos[3], E[9], a[3], e[3], vs[3], cosel, v, h[4];
     int i, j, nv = 0;
 
     //    trace(3,"resdop  : n=%d\n",n);
@@ -782,12 +999,13 @@ static int resdop(const obsd_t *obs, int n, const double *rs, const double *dts,
         rate = dot(vs, e, 3) + OMGE / CLIGHT * (rs[4 + i * 6] * rr[0] + rs[1 + i * 6] * x[0] - rs[3 + i * 6] * rr[1] - rs[i * 6] * x[1]);
 
         /* doppler residual */
-        v[nv] = -lam * obs[i].D[0] - (rate + x[3] - CLIGHT * dts[1 + i * 2]);
+        v = -lam * obs[i].D[0] - (rate + x[3] - CLIGHT * dts[1 + i * 2]);
 
         /* design matrix */
         for (j = 0; j < 4; j++)
-            H[j + nv * 4] = j < 3 ? -e[j] : 1.0;
+            h[j] = j < 3 ? -e[j] : 1.0;
 
+        addrow_lsqr(lsq, h, v, 1.0);
         nv++;
     }
     return nv;
@@ -806,29 +1024,31 @@ static int resdop(const obsd_t *obs, int n, const double *rs, const double *dts,
  * 返回类型:
  * int                O     (1:ok,0:error)
  * 不像定位时，初值为上一历元的位置，定速直接给的0
+ * 接收机钟漂存入 sol->dtr[5]，供下一历元预测初始钟差
  */
 static void estvel(const obsd_t *obs, int n, const double *rs, const double *dts,
                    const nav_t *nav, const prcopt_t *opt, sol_t *sol,
                    const double *azel, const int *vsat)
 {
-    double x[4] = {0}, dx[4], Q[16], v[MAXOBS], H[4 * MAXOBS];
+    lsqr_t lsq;
+    double x[4] = {0}, dx[4], Q[16];
     int i, j, nv;
 
     //    trace(3,"estvel  : n=%d\n",n);
 
-    //    v=mat(n,1); H=mat(4,n);
     //* 1、在最大迭代次数限制内，调用resdop，计算定速方程组左边的几何矩阵和右端的速度残余，返回定速时所使用的卫星数目。
     for (i = 0; i < MAXITR; i++)
     {
 
         /* doppler residuals */
-        if ((nv = resdop(obs, n, rs, dts, nav, sol->rr, x, azel, vsat, v, H)) < 4)
+        init_lsqr(&lsq, 4);
+        if ((nv = resdop(obs, n, rs, dts, nav, sol->rr, x, azel, vsat, &lsq)) < 4)
         {
             break;
         }
         /* least square estimation */
-        //* 2、调用 lsq函数，解出 {速度、频漂}的步长，累加到 x中。
-        if (lsq(H, v, 4, nv, dx, Q))
+        //* 2、调用 solve_lsqr函数，解出 {速度、频漂}的步长，累加到 x中。
+        if (solve_lsqr(&lsq, dx, Q))
             break;
 
         for (j = 0; j < 4; j++)
@@ -838,7 +1058,8 @@ static void estvel(const obsd_t *obs, int n, const double *rs, const double *dts
         if (norm(dx, 4) < 1E-6)
         {
             for (i = 0; i < 3; i++)
-                sol->rr[i + 3] = x[i]; //! 注意，最后并没有存储计算出的接收器的时钟漂移
+                sol->rr[i + 3] = x[i];
+            sol->dtr[5] = x[3] / CLIGHT; /* receiver clock drift (s/s) */
             break;
         }
     }
@@ -866,17 +1087,26 @@ extern int pntpos(const obsd_t *obs, int n, nav_t *nav,
                   char *msg)
 {
     prcopt_t opt_ = *opt;
+    corr_t corr;
     double rs[6 * MAXOBS], dts[2 * MAXOBS], var[MAXOBS], azel_[2 * MAXOBS], resp[MAXOBS];
     //    double *rs,*dts,*var,*azel_,*resp;
-    int i, stat, vsat[MAXOBS] = {0}, svh[MAXOBS];
+    int i, stat, warm, vsat[MAXOBS] = {0}, svh[MAXOBS];
 
-    sol->stat = SOLQ_NONE;
     //* 1、检查卫星个数是否>0
     if (n <= 0)
     {
+        sol->stat = SOLQ_NONE;
         strcpy(msg, "no observation data");
         return 0;
     }
+    //* 由上一历元的解预测初始位置、钟差 (须在 sol->stat、sol->time更新前)
+    warm = predsol(obs[0].time, sol);
+
+    sol->stat = SOLQ_NONE;
+    sol->wtest = 0.0f;
+    sol->exsat = 0;
+    sol->niter = 0;
+    corr.iter = -1;
 
     // trace(3,"pntpos  : tobs=%s n=%d\n",time_str(obs[0].time,3),n);
 
@@ -900,7 +1130,8 @@ extern int pntpos(const obsd_t *obs, int n, nav_t *nav,
     /* estimate receiver position with pseudorange */
     //* 4、通过伪距实现绝对定位，计算出接收机的位置和钟差，顺带返回实现定位后每颗卫星的(\
     //*     方位角，仰角)、定位时有效性、定位后的伪距残差
-    stat = estpos(obs, n, rs, dts, var, svh, nav, &opt_, sol, azel_, vsat, resp, msg);
+    stat = estpos(obs, n, rs, dts, var, svh, nav, &opt_, warm, &corr, sol, azel_, vsat, resp,
+                  msg);
 
     //* 5、对上一步得到的定位结果进行接收机自主正直性检测（RAIM）。通过再次使用 vsat数组，
     //*     这里只会在对定位结果有贡献的卫星数据进行检测。
@@ -908,13 +1139,13 @@ extern int pntpos(const obsd_t *obs, int n, nav_t *nav,
     if (!stat && n >= 6 && opt->posopt[4])
     {
         // if (!stat&&n>=6) {
-        stat = raim_fde(obs, n, rs, dts, var, svh, nav, &opt_, sol, azel_, vsat, resp, msg);
+        stat = raim_fde(obs, n, rs, dts, var, svh, nav, &opt_, &corr, sol, azel_, vsat, resp,
+                        msg);
     }
     /* estimate receiver velocity with doppler */
     //* 6、 调用 estvel函数，依靠多普勒频移测量值计算接收机的速度。
     //*     这里只使用通过了上一步RAIM_FDE操作的卫星数据，所以对于计算出的速度就没有再次进行 RAIM了。
-    //* 这里只计算了接收机的钟差，而没有计算接收机的频漂，
-    //*     原因在于 estvel函数中虽然计算得到了接收机频漂，但并没有将其输出到 sol_t:dtr中。
+    //* 接收机频漂输出到 sol_t:dtr[5]，与速度一起用于下一历元的初始状态预测。
     if (stat)
         estvel(obs, n, rs, dts, nav, &opt_, sol, azel_, vsat);
 
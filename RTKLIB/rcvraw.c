@@ -753,6 +753,8 @@ extern int decode_frame(const unsigned char *buff, eph_t *eph, alm_t *alm,
 extern int init_raw(raw_t *raw)
 {
     const double lam_glo[NFREQ]={CLIGHT/FREQ1_GLO,CLIGHT/FREQ2_GLO};
+    const double lam_gal[NFREQ]={CLIGHT/FREQ1,CLIGHT/FREQ7,CLIGHT/FREQ5};
+    const double lam_cmp[NFREQ]={CLIGHT/FREQ1_CMP,CLIGHT/FREQ2_CMP,CLIGHT/FREQ5};
     gtime_t time0={0};
     obsd_t data0={{0}};
     eph_t  eph0 ={0,-1,-1};
@@ -769,8 +771,9 @@ extern int init_raw(raw_t *raw)
     raw->ephsat=0;
     raw->sbsmsg=sbsmsg0;
     raw->msgtype[0]='\0';
+    memset(&raw->subfrm,0,sizeof(subfrm_t));
     for (i=0;i<MAXSAT;i++) {
-        for (j=0;j<150  ;j++) raw->subfrm[i][j]=0;
+        raw->ephfp[i]=0;
         for (j=0;j<NFREQ;j++) raw->lockt[i][j]=0.0;
         for (j=0;j<NFREQ;j++) raw->halfc[i][j]=0;
         raw->icpp[i]=raw->off[i]=raw->prCA[i]=raw->dpCA[i]=0.0;
@@ -779,8 +782,17 @@ extern int init_raw(raw_t *raw)
     raw->lexmsg=lexmsg0;
     raw->icpc=0.0;
     raw->nbyte=raw->len=0;
+    raw->cka=raw->ckb=0;
+    raw->nnav[0]=raw->nnav[1]=0;
     raw->iod=raw->flag=raw->tbase=raw->outtype=0;
     raw->tod=-1;
+    memset(&raw->rsol,0,sizeof(rcvsol_t));
+    memset(raw->ubxstat,0,sizeof(raw->ubxstat));
+    memset(raw->ubxhash,0,sizeof(raw->ubxhash));
+    raw->nubxhash=0;
+    raw->ubxcfg=NULL;
+    raw->evtw=raw->evtr=raw->nevtlost=0;
+    raw->tarr=0;
     for (i=0;i<MAXRAWLEN;i++) raw->buff[i]=0;
     raw->opt[0]='\0';
     
@@ -817,7 +829,8 @@ extern int init_raw(raw_t *raw)
     for (i=0;i<NSATSBS*2;i++) raw->nav.seph [i]=seph0;
     for (i=0;i<MAXSAT;i++) for (j=0;j<NFREQ;j++) {
         if (!(sys=satsys(i+1,NULL))) continue;
-        raw->nav.lam[i][j]=sys==SYS_GLO?lam_glo[j]:lam_carr[j];
+        raw->nav.lam[i][j]=sys==SYS_GLO?lam_glo[j]:(sys==SYS_GAL?lam_gal[j]:
+                           (sys==SYS_CMP?lam_cmp[j]:lam_carr[j]));
     }
     raw->sta.name[0]=raw->sta.marker[0]='\0';
     raw->sta.antdes[0]=raw->sta.antsno[0]='\0';
@@ -873,6 +886,73 @@ extern int input_raw(raw_t *raw, int format, unsigned char data)
     }
     return 0;
 }
+/* input receiver raw data from stream block -----------------------------------
+* fetch receiver raw data from a block of stream data and input all messages
+* args   : raw_t  *raw   IO     receiver raw data control struct
+*          int    format I      receiver raw data format (STRFMT_???)
+*          unsigned char *buff I stream data
+*          int    n      I      length of stream data (bytes)
+*          rawfunc_t func I     callback for each message with non-zero status
+*                               (NULL: no callback)
+* return : number of messages with non-zero status in the block
+*-----------------------------------------------------------------------------*/
+extern int input_raw_block(raw_t *raw, int format, const unsigned char *buff,
+                           int n, rawfunc_t func)
+{
+    int i,stat,nmsg=0;
+    
+    switch (format) {
+        case STRFMT_UBX  : return input_ubx_block(raw,buff,n,func);
+    }
+    for (i=0;i<n;i++) {
+        if (!(stat=input_raw(raw,format,buff[i]))) continue;
+        nmsg++;
+        if (func) func(raw,stat);
+    }
+    return nmsg;
+}
+/* push receiver raw event -----------------------------------------------------
+* push an event to the raw event queue by the decoders
+* args   : raw_t  *raw    IO    receiver raw data control struct
+*          int    type    I     event type (EVT_???)
+*          int    sat     I     satellite number (0: none)
+* return : status (1:ok,0:queue full, event lost)
+* notes  : the event carries the arrival tick of the input data (raw->tarr)
+*          and the tick of the decoding.
+*-----------------------------------------------------------------------------*/
+extern int push_rawevt(raw_t *raw, int type, int sat)
+{
+    rawevt_t *evt;
+    
+    if (raw->evtw-raw->evtr>=MAXRAWEVT) {
+        raw->nevtlost++;
+        return 0;
+    }
+    evt=raw->evt+(raw->evtw&(MAXRAWEVT-1));
+    evt->type=type;
+    evt->sat=sat;
+    evt->time=raw->time;
+    evt->tarr=raw->tarr;
+    evt->tdec=tickcnt();
+    raw->evtw++;
+    return 1;
+}
+/* get receiver raw event ------------------------------------------------------
+* get the oldest event from the raw event queue
+* args   : raw_t  *raw    IO    receiver raw data control struct
+*          rawevt_t *evt  O     raw event
+* return : status (1:ok,0:no event)
+* notes  : raw->obs holds the observation data of the latest EVT_OBS only.
+*          drain the queue after each decoded message (rawfunc_t callback of
+*          input_raw_block() or input_demux()) to process every epoch of a
+*          block. an event lost by queue full is counted in raw->nevtlost.
+*-----------------------------------------------------------------------------*/
+extern int get_rawevt(raw_t *raw, rawevt_t *evt)
+{
+    if (raw->evtr==raw->evtw) return 0;
+    *evt=raw->evt[raw->evtr++&(MAXRAWEVT-1)];
+    return 1;
+}
 /* input receiver raw data from file,ļнյԭʼ -------------------------------------------
 * fetch next receiver raw data and input a message from file
 * args   : raw_t  *raw   IO     receiver raw data control struct
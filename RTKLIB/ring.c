@@ -0,0 +1,279 @@
+/*------------------------------------------------------------------------------
+ * ring.c : single-producer/single-consumer byte ring and record queue
+ *
+ * description : lock-free byte ring between one producer (uart receive
+ *               interrupt, reader thread) and one consumer (processing loop).
+ *               the producer only writes head and the producer statistics,
+ *               the consumer only writes tail, so no lock or interrupt mask is
+ *               needed as long as head/tail are read and written atomically
+ *               (aligned 32 bit words). the buffer size is a power of 2 and
+ *               head/tail are free-running byte counts.
+ *               the consumer reads received bytes in place by peek_ring() and
+ *               releases them by skip_ring(), so the frames are decoded
+ *               directly from the ring.
+ *               the record queue (outq_t) passes whole output records (nmea
+ *               epoch output) from the processing loop to a sender (uart
+ *               transmit interrupt, writer thread) in NOUTQ fixed slots
+ *               (record index mod NOUTQ). the producer never waits: the record
+ *               is formatted in place in the next slot and committed. if the
+ *               sender falls behind, the oldest unsent record is overwritten
+ *               (drop-oldest) and the sender resumes at the oldest record
+ *               left, so only complete records are sent. the slot of the
+ *               record in flight is never overwritten; its index is skipped
+ *               by the producer and left empty. the records dropped are
+ *               nrec-nsent-(records pending).
+ *
+ * history : 2026/10/17 1.0 new
+ *-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+/* memory barrier between ring data and head/tail access ---------------------*/
+#if defined(__CC_ARM)
+#define RING_BARRIER() __dmb(0xF)
+#elif defined(__GNUC__)
+#define RING_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define RING_BARRIER() _ReadWriteBarrier()
+#else
+#define RING_BARRIER()
+#endif
+
+/* initialize byte ring --------------------------------------------------------
+ * args   : ring_t *ring  O     byte ring
+ *          unsigned char *buff I ring buffer
+ *          unsigned int size I size of ring buffer (bytes) (power of 2)
+ * return : status (1:ok,0:size not power of 2)
+ * notes  : initialize before the producer is started (interrupt enabled).
+ *-----------------------------------------------------------------------------*/
+extern int init_ring(ring_t *ring, unsigned char *buff, unsigned int size)
+{
+    memset(ring, 0, sizeof(ring_t));
+    if (size == 0 || (size & (size - 1)))
+        return 0;
+    ring->buff = buff;
+    ring->size = size;
+    return 1;
+}
+/* put byte to ring (producer) -------------------------------------------------
+ * args   : ring_t *ring  IO    byte ring
+ *          unsigned char data I byte
+ * return : status (1:ok,0:ring full, byte dropped)
+ * notes  : call from the uart receive interrupt. a dropped byte is counted in
+ *          ring->nlost and a run of dropped bytes in ring->novf. the arrival
+ *          tick of the byte is set to ring->tick.
+ *-----------------------------------------------------------------------------*/
+extern int put_ring(ring_t *ring, unsigned char data)
+{
+    unsigned int head = ring->head, n = head - ring->tail;
+
+    if (n >= ring->size)
+    {
+        if (!ring->full)
+        {
+            ring->novf++;
+            ring->full = 1;
+        }
+        ring->nlost++;
+        return 0;
+    }
+    ring->buff[head & (ring->size - 1)] = data;
+    ring->tick = tickcnt();
+    RING_BARRIER();
+    ring->head = head + 1;
+    ring->full = 0;
+    if (n + 1 > ring->hwm)
+        ring->hwm = n + 1;
+    return 1;
+}
+/* write bytes to ring (producer) ----------------------------------------------
+ * args   : ring_t *ring  IO    byte ring
+ *          unsigned char *buff I data
+ *          int    n      I     length of data (bytes)
+ * return : number of bytes written (bytes not written are counted as lost)
+ *-----------------------------------------------------------------------------*/
+extern int write_ring(ring_t *ring, const unsigned char *buff, int n)
+{
+    unsigned int head = ring->head, used = head - ring->tail, off, len;
+    int nw = n < (int)(ring->size - used) ? n : (int)(ring->size - used);
+
+    if (nw < n)
+    {
+        if (!ring->full)
+        {
+            ring->novf++;
+            ring->full = 1;
+        }
+        ring->nlost += n - nw;
+    }
+    if (nw <= 0)
+        return 0;
+
+    off = head & (ring->size - 1);
+    len = ring->size - off < (unsigned int)nw ? ring->size - off : (unsigned int)nw;
+    memcpy(ring->buff + off, buff, len);
+    memcpy(ring->buff, buff + len, nw - len);
+    ring->tick = tickcnt();
+    RING_BARRIER();
+    ring->head = head + nw;
+    if (nw == n)
+        ring->full = 0;
+    if (used + nw > ring->hwm)
+        ring->hwm = used + nw;
+    return nw;
+}
+/* peek received bytes in ring (consumer) --------------------------------------
+ * args   : ring_t *ring  I     byte ring
+ *          unsigned char **p O start of received bytes in ring buffer
+ * return : number of received bytes contiguous from *p (0: empty)
+ * notes  : bytes wrapped around the buffer end are returned by the next call
+ *          after skip_ring().
+ *-----------------------------------------------------------------------------*/
+extern int peek_ring(ring_t *ring, const unsigned char **p)
+{
+    unsigned int tail = ring->tail, n = ring->head - tail, off;
+
+    RING_BARRIER();
+    off = tail & (ring->size - 1);
+    *p = ring->buff + off;
+    return (int)(ring->size - off < n ? ring->size - off : n);
+}
+/* release bytes read from ring (consumer) -------------------------------------
+ * args   : ring_t *ring  IO    byte ring
+ *          int    n      I     number of bytes to release (<= peek_ring())
+ * return : none
+ *-----------------------------------------------------------------------------*/
+extern void skip_ring(ring_t *ring, int n)
+{
+    RING_BARRIER();
+    ring->tail += n;
+}
+/* initialize output record queue ---------------------------------------------
+ * args   : outq_t *q     O     output record queue
+ * return : none
+ *-----------------------------------------------------------------------------*/
+extern void init_outq(outq_t *q)
+{
+    memset(q, 0, sizeof(outq_t));
+}
+/* allocate output record (producer) -------------------------------------------
+ * args   : outq_t *q     IO    output record queue
+ * return : record buffer (MAXOUTREC bytes)
+ * notes  : format the record in the buffer and commit it by commit_outq().
+ *          only one record is allocated at a time. an unsent record in the
+ *          slot is dropped.
+ *-----------------------------------------------------------------------------*/
+extern unsigned char *alloc_outq(outq_t *q)
+{
+    unsigned int head, cur, i;
+
+    for (;;)
+    {
+        head = q->head;
+        RING_BARRIER();
+        cur = q->cur;
+        i = head & (NOUTQ - 1);
+        if (!cur || i != ((cur - 1) & (NOUTQ - 1)))
+            break;
+        q->head = head + 1; /* skip slot in flight (empty index) */
+    }
+    return q->buff[i];
+}
+/* commit output record (producer) ---------------------------------------------
+ * args   : outq_t *q     IO    output record queue
+ *          int    len    I     record length (bytes) (<= MAXOUTREC)
+ * return : none (an empty record is not committed)
+ *-----------------------------------------------------------------------------*/
+extern void commit_outq(outq_t *q, int len)
+{
+    unsigned int head = q->head, i = head & (NOUTQ - 1);
+
+    if (len <= 0)
+        return;
+    q->len[i] = len < MAXOUTREC ? len : MAXOUTREC;
+    q->seq[i] = head;
+    q->tcom[i] = tickcnt();
+    RING_BARRIER();
+    q->head = head + 1;
+    q->nrec++;
+}
+/* write output record (producer) ----------------------------------------------
+ * args   : outq_t *q     IO    output record queue
+ *          unsigned char *buff I record
+ *          int    n      I     record length (bytes) (truncated to MAXOUTREC)
+ * return : none
+ *-----------------------------------------------------------------------------*/
+extern void write_outq(outq_t *q, const unsigned char *buff, int n)
+{
+    unsigned char *p = alloc_outq(q);
+
+    if (n > MAXOUTREC)
+        n = MAXOUTREC;
+    memcpy(p, buff, n);
+    commit_outq(q, n);
+}
+/* peek output bytes to send (consumer) ----------------------------------------
+ * args   : outq_t *q     IO    output record queue
+ *          unsigned char **p O start of unsent bytes of record in flight
+ * return : number of unsent bytes of record in flight (0: queue empty)
+ * notes  : if no record is in flight, the oldest record left is taken. the
+ *          record is claimed (cur) before head is checked again, so a record
+ *          being overwritten by the producer is never taken.
+ *-----------------------------------------------------------------------------*/
+extern int peek_outq(outq_t *q, const unsigned char **p)
+{
+    unsigned int head, rd, i;
+
+    while (!q->cur)
+    {
+        head = q->head;
+        rd = q->rd;
+        if (head - rd >= NOUTQ)
+            rd = head - (NOUTQ - 1); /* older records overwritten */
+        if (rd == head)
+        {
+            q->rd = rd;
+            return 0;
+        }
+        q->cur = rd + 1;
+        RING_BARRIER();
+        if (q->head - rd >= NOUTQ)
+            q->rd = rd; /* overwritten while claimed */
+        else if (q->seq[rd & (NOUTQ - 1)] != rd)
+            q->rd = rd + 1; /* empty index */
+        else
+        {
+            q->rd = rd + 1;
+            q->off = 0;
+            break;
+        }
+        q->cur = 0;
+    }
+    RING_BARRIER();
+    i = (q->cur - 1) & (NOUTQ - 1);
+    *p = q->buff[i] + q->off;
+    return q->len[i] - (int)q->off;
+}
+/* release bytes sent from output record (consumer) ----------------------------
+ * args   : outq_t *q     IO    output record queue
+ *          int    n      I     number of bytes sent (<= peek_outq())
+ * return : none
+ * notes  : when the record is sent, the time from commit to the last byte
+ *          handed to the transport is set to q->tout (ticks).
+ *-----------------------------------------------------------------------------*/
+extern void skip_outq(outq_t *q, int n)
+{
+    unsigned int i = (q->cur - 1) & (NOUTQ - 1);
+
+    q->off += n;
+    q->nbyte += n;
+    if (q->off >= (unsigned int)q->len[i])
+    {
+        q->tout = tickcnt() - q->tcom[i];
+        if (q->tout > q->toutmax)
+            q->toutmax = q->tout;
+        q->nsent++;
+        RING_BARRIER();
+        q->cur = 0;
+    }
+}
@@ -1,3 +1,6 @@
+#if defined(WIN32)||defined(_WIN32)
+#include <windows.h>
+#endif
 #include "rtklib.h"
 #include <time.h>
 const static double gpst0[]={1980,1, 6,0,0,0}; /* gps time reference */
@@ -531,6 +534,26 @@ extern double timediff(gtime_t t1, gtime_t t2)
 {
     return difftime(t1.time,t2.time)+t1.sec-t2.sec;
 }
+/* get current tick ------------------------------------------------------------
+* get current tick of monotonic counter for latency measurement
+* args   : none
+* return : current tick (TICKFREQ ticks/s)
+* notes  : the counter wraps around at 2^32 ticks (19.9 s on target, 71 min on
+*          host). take differences of ticks by unsigned subtraction.
+*-----------------------------------------------------------------------------*/
+extern unsigned int tickcnt(void)
+{
+#if defined(STM32F767xx)
+    return DWT->CYCCNT; /* enable DWT cycle counter */
+#elif defined(WIN32)||defined(_WIN32)
+    return (unsigned int)GetTickCount64(); /* ms since system start */
+#else
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (unsigned int)ts.tv_sec*1000000u+(unsigned int)(ts.tv_nsec/1000);
+#endif
+}
 /* time to string --------------------------------------------------------------
 * convert gtime_t struct to string
 * args   : gtime_t t        I   gtime_t struct
@@ -670,7 +693,7 @@ extern int matinv(double *A, int n)
 //    indx=imat(n,1); 
 //		B=mat(n,n); 
 		matcpy(B,A,n,n);
-    if (ludcmp(B,n,indx,&d)) {free(indx); free(B); return -1;}
+    if (ludcmp(B,n,indx,&d)) return -1; // free(indx); free(B);
     for (j=0;j<n;j++) {
         for (i=0;i<n;i++) A[i+j*n]=0.0;
         A[j+j*n]=1.0;
@@ -751,13 +774,15 @@ extern int satexclude(int sat, int svh, const prcopt_t *opt)
    //!      这样做的好处是当 opt->navsys=sys或 opt->navsys=SYS_ALL时，结果都会为真。
    //!      之所以会这样，是因为在 rtklib.h文件中定义这些导航系统变量的时候，所赋的值在二进制形式下都是只有一位为 1的数。
    if (opt) {
+#if 0 /* exsats not in prcopt_t */
        if (opt->exsats[sat-1]==1) return 1; /* excluded satellite */
        if (opt->exsats[sat-1]==2) return 0; /* included satellite */
+#endif
        if (!(sys&opt->navsys)) return 1; /* unselected sat sys */
    }
    if (sys==SYS_QZS) svh&=0xFE; /* mask QZSS LEX health */
    //* 4、如果此时 svh>0，说明此时卫星健康状况出现问题，此卫星不可用，返回 1。
-   if (svh) {tests
+   if (svh) {
        //trace(3,"unhealthy satellite: sat=%3d svh=%02X\n",sat,svh);
        return 1;
    }
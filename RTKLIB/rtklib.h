@@ -5,10 +5,10 @@
 #include <stdarg.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
+#ifdef STM32F767xx
 #include "usart.h"
-
-extern unsigned char ublox_raw_flag;
-extern unsigned char ublox_eph_flag;
+#endif
 
 #define ENAGLO 1 // 1.,0.
 #define ENACMP 1
@@ -132,11 +132,13 @@ extern unsigned char ublox_eph_flag;
 #define MINPRNCMP 1                         /* min satellite sat number of BeiDou */
 #define MAXPRNCMP 35                        /* max satellite sat number of BeiDou */
 #define NSATCMP (MAXPRNCMP - MINPRNCMP + 1) /* number of BeiDou satellites */
+#define NSATBDSGEO 5                        /* number of BeiDou GEO satellites (D2) */
 #define NSYSCMP 1
 #else
 #define MINPRNCMP 0
 #define MAXPRNCMP 0
 #define NSATCMP 0
+#define NSATBDSGEO 0
 #define NSYSCMP 0
 #endif
 #ifdef ENAIRN
@@ -186,7 +188,7 @@ extern unsigned char ublox_eph_flag;
 #define MAXSTRRTK 8       /* max number of stream in RTK server */
 #define MAXSBSMSG 32      /* max number of SBAS msg in RTK server */
 #define MAXSOLMSG 4096    /* max length of solution message */
-#define MAXRAWLEN 4096    /* max length of receiver raw message */
+#define MAXRAWLEN 8192    /* max length of receiver raw message (rxm-rawx 255 meas: 8184) */
 #define MAXERRMSG 4096    /* max length of error/warning message ??/?????????*/
 #define MAXANT 64         /* max length of station name/antenna type???/????????? */
 #define MAXSOLBUF 256     /* max number of solution buffer?????????? */
@@ -355,6 +357,7 @@ extern unsigned char ublox_eph_flag;
 #define STR_NTRIPCLI 7 /* stream type: NTRIP client */
 #define STR_FTP 8      /* stream type: ftp */
 #define STR_HTTP 9     /* stream type: http */
+#define STR_PTY 10     /* stream type: pseudo-terminal */
 
 #define STRFMT_RTCM2 0   /* stream format: RTCM 2 */
 #define STRFMT_RTCM3 1   /* stream format: RTCM 3 */
@@ -523,7 +526,7 @@ typedef struct
     //    pcv_t pcvr[2];      /* receiver antenna parameters {rov,base} */
     //    unsigned char exsats[MAXSAT]; /* excluded satellites (1:excluded,2:included) */
     //    char rnxopt[2][256]; /* rinex options {rover,base} */
-    //    int  posopt[6];     /* positioning options */
+    int posopt[6];      /* positioning options ([4]:raim fde) */
     //    int  syncsol;       /* solution sync mode (0:off,1:on) */
     //    double odisp[2][6*11]; /* ocean tide loading parameters {rov,base} */
     //    exterr_t exterr;    /* extended receiver error model */
@@ -669,6 +672,85 @@ typedef struct
     double hgt;           /* antenna height (m) */
 } sta_t;
 
+typedef struct
+{                               /* receiver navigation solution type */
+    gtime_t time;               /* solution time (gpst) */
+    int stat;                   /* fix type (0:no fix,1:dr,2:2d,3:3d,4:gnss+dr,5:time) */
+    int ns;                     /* number of satellites used */
+    double rr[6];               /* position/velocity (ecef) (m,m/s) */
+    gtime_t tclk;               /* clock solution time (gpst) */
+    double dtr[2];              /* receiver clock bias/drift (s,s/s) */
+    gtime_t ttp;                /* time of next time pulse (gpst) */
+    double qerr;                /* time pulse quantization error (s) */
+    gtime_t tsat;               /* satellite status time (gpst) */
+    double azel[MAXSAT][2];     /* satellite azimuth/elevation angle (rad) */
+    unsigned char cno[MAXSAT];  /* satellite signal strength (dBHz) (0:not tracked) */
+    unsigned char vsat[MAXSAT]; /* satellite used in solution (1:used,0:not) */
+} rcvsol_t;
+
+#define NUBXSTAT 32 /* size of ubx message statistics table (power of 2) */
+#define NUBXHASH 32 /* size of ubx decoder hash index (power of 2) */
+
+typedef struct
+{                        /* ubx message statistics type */
+    unsigned short type; /* message class/id (0: empty) */
+    unsigned int n;      /* number of valid messages */
+    unsigned int bytes;  /* number of bytes of valid messages (incl. header) */
+    unsigned int ncs;    /* number of checksum errors */
+    unsigned int tdec;   /* accumulated decode time (ticks of UBXTICK()) */
+} ubxstat_t;
+
+#define MAXRAWEVT 16 /* size of receiver raw event queue (power of 2) */
+#define EVT_OBS 1    /* raw event: observation data ready */
+#define EVT_EPH 2    /* raw event: ephemeris of satellite updated */
+#define EVT_SBAS 3   /* raw event: sbas message */
+#define EVT_IONUTC 9 /* raw event: ion/utc parameters updated */
+
+#if defined(STM32F767xx)
+#define TICKFREQ 216E6 /* frequency of tickcnt() (cpu cycles) */
+#elif defined(WIN32) || defined(_WIN32)
+#define TICKFREQ 1E3 /* ms */
+#else
+#define TICKFREQ 1E6 /* us */
+#endif
+
+typedef struct
+{                      /* receiver raw event type */
+    int type;          /* event type (EVT_???) */
+    int sat;           /* satellite number (EVT_EPH,EVT_SBAS) (0: none) */
+    gtime_t time;      /* message time (EVT_OBS: observation time) */
+    unsigned int tarr; /* arrival tick of message (tickcnt()) */
+    unsigned int tdec; /* decoded tick of message (tickcnt()) */
+} rawevt_t;
+
+#define MAXUBXCFG 64 /* max number of frames of ubx cfg transaction */
+
+typedef int (*ubxwrite_t)(const unsigned char *buff, int n); /* non-blocking write (return: bytes written) */
+typedef struct
+{                                      /* ubx cfg transaction type */
+    const unsigned char *buff;         /* cfg blob (concatenated ubx frames) */
+    int nfrm;                          /* number of frames */
+    int window;                        /* max frames waiting ack (0: no limit) */
+    unsigned int tout;                 /* ack timeout (ticks) */
+    unsigned short off[MAXUBXCFG + 1]; /* frame offsets in blob */
+    unsigned char stat[MAXUBXCFG];     /* frame status (0:unsent,1:wait ack,2:ack,3:nak,4:timeout) */
+    unsigned int tsent[MAXUBXCFG];     /* frame sent time (ticks) */
+    int isend;                         /* index of frame to send */
+    int nbyte;                         /* bytes of frame isend written */
+    int iack;                          /* index of oldest frame waiting ack */
+    int nack, nnak, ntout;             /* number of ack/nak/timeout frames */
+} ubxcfg_t;
+
+typedef struct
+{                                                 /* navigation data subframe assembly type */
+    unsigned char gps[NSATGPS + NSATQZS][90];     /* GPS/QZSS subframe 1-3 (3x30 bytes) */
+    unsigned char glo[NSATGLO][42];               /* GLONASS string 1-4 (4x10 bytes) + frame-id */
+    unsigned char gal[NSATGAL][112];              /* Galileo I/NAV word 0-6 (7x16 bytes) */
+    unsigned char bds[NSATCMP - NSATBDSGEO][114]; /* BeiDou D1 subframe 1-3 (3x38 bytes) */
+    unsigned char geo[NSATBDSGEO][380];           /* BeiDou D2 subframe 1 page 1-10 (10x38 bytes) */
+    unsigned short mask[MAXSAT];                  /* page complete bitmask (bit n: page n+1) */
+} subfrm_t;
+
 typedef struct
 {                                               /* RTCM control struct type */
     int staid;                                  /* station id */
@@ -712,7 +794,9 @@ typedef struct
     int ephsat;                                  /* sat number of update ephemeris (0:no satellite)??????? */
     sbsmsg_t sbsmsg;                             /* SBAS message */
     char msgtype[256];                           /* last message type ????????*/
-    unsigned char subfrm[MAXSAT][150];           /* subframe buffer (1-5)???? */
+    subfrm_t subfrm;                             /* subframe assembly buffer */
+    unsigned int ephfp[MAXSAT];                  /* ephemeris fingerprint (0: none) */
+    unsigned int nnav[2];                        /* nav data decoded/skipped by fingerprint */
     lexmsg_t lexmsg;                             /* LEX message */
     double lockt[MAXSAT][NFREQ + NEXOBS];        /* lock time (s)???? */
     double icpp[MAXSAT], off[MAXSAT], icpc;      /* carrier params for ss2ss2???? */
@@ -721,15 +805,105 @@ typedef struct
     char freqn[MAXOBS];                          /* frequency number for javad */
     int nbyte;                                   /* number of bytes in message buffer */
     int len;                                     /* message length (bytes) */
+    unsigned char cka, ckb;                      /* running checksum of message */
     int iod;                                     /* issue of data */
     int tod;                                     /* time of day (ms) */
     int tbase;                                   /* time base (0:gpst,1:utc(usno),2:glonass,3:utc(su) */
     int flag;                                    /* general purpose flag */
     int outtype;                                 /* output message type */
+    rcvsol_t rsol;                               /* receiver navigation solution */
+    ubxstat_t ubxstat[NUBXSTAT];                 /* ubx message statistics (hashed by class/id) */
+    unsigned char ubxhash[NUBXHASH];             /* ubx decoder hash index (decoder index+1,0:empty) */
+    int nubxhash;                                /* number of decoders in hash index (0:not built) */
+    ubxcfg_t *ubxcfg;                            /* ubx cfg transaction for ack (NULL: none) */
+    rawevt_t evt[MAXRAWEVT];                     /* raw event queue */
+    unsigned int evtw, evtr;                     /* raw event queue write/read count */
+    unsigned int nevtlost;                       /* number of raw events lost by queue full */
+    unsigned int tarr;                           /* arrival tick of input data (tickcnt()) (set by caller) */
     unsigned char buff[MAXRAWLEN];               /* message buffer */
                                                  //    int prn[MAXOBS];      //ӵPRN
     char opt[256];                               /* receiver dependent options ???????,????????*/
 } raw_t;
+typedef void (*rawfunc_t)(raw_t *raw, int stat); /* receiver raw message callback */
+
+#define DMX_UBX 0   /* demux protocol: ublox binary */
+#define DMX_NMEA 1  /* demux protocol: NMEA 0183 */
+#define DMX_RTCM3 2 /* demux protocol: RTCM 3 */
+#define NDMX 3      /* number of demux protocols */
+
+typedef void (*dmxfunc_t)(int type, const unsigned char *frm, int len); /* demux frame callback */
+typedef struct
+{                                  /* stream demultiplexer type */
+    raw_t *raw;                    /* receiver raw data control for ubx (NULL: none) */
+    rawfunc_t rawfunc;             /* ubx decode status callback (NULL: none) */
+    dmxfunc_t func;                /* valid frame callback (NULL: none) */
+    int type;                      /* protocol of partial frame (DMX_???) */
+    int nbyte;                     /* number of bytes of partial frame */
+    int len;                       /* partial frame length (0: header incomplete) */
+    unsigned int nframe[NDMX];     /* number of valid frames */
+    unsigned int nbytes[NDMX];     /* number of bytes in valid frames */
+    unsigned int nerr[NDMX];       /* number of checksum/crc errors */
+    unsigned int nskip;            /* number of bytes outside valid frames */
+    unsigned char buff[MAXRAWLEN]; /* partial frame buffer */
+} demux_t;
+
+typedef struct
+{                                /* single-producer/single-consumer byte ring type */
+    unsigned char *buff;         /* ring buffer */
+    unsigned int size;           /* size of ring buffer (bytes) (power of 2) */
+    volatile unsigned int head;  /* bytes written (producer) */
+    volatile unsigned int tail;  /* bytes read (consumer) */
+    volatile unsigned int hwm;   /* high-water mark (bytes) (producer) */
+    volatile unsigned int nlost; /* number of bytes dropped by ring full (producer) */
+    volatile unsigned int novf;  /* number of ring full events (producer) */
+    volatile int full;           /* ring full state (producer) */
+    volatile unsigned int tick;  /* arrival tick of last byte (tickcnt()) (producer) */
+} ring_t;
+
+#define NOUTQ 4        /* number of record slots of output queue (power of 2) */
+#define MAXOUTREC 2048 /* max length of output queue record (bytes) */
+
+typedef struct
+{                                         /* output record queue type */
+    unsigned char buff[NOUTQ][MAXOUTREC]; /* record slots */
+    int len[NOUTQ];                       /* record lengths (bytes) */
+    volatile unsigned int seq[NOUTQ];     /* record indexes in slots */
+    volatile unsigned int head;           /* next record index (producer) */
+    volatile unsigned int rd;             /* next record index to send (consumer) */
+    volatile unsigned int cur;            /* record index in flight + 1 (0: none) (consumer) */
+    unsigned int off;                     /* bytes sent of record in flight (consumer) */
+    unsigned int tcom[NOUTQ];             /* record commit ticks (tickcnt()) */
+    volatile unsigned int tout, toutmax;  /* commit to sent of last record/max (ticks) (consumer) */
+    volatile unsigned int nrec;           /* number of records committed (producer) */
+    volatile unsigned int nsent;          /* number of records sent (consumer) */
+    volatile unsigned int nbyte;          /* number of bytes sent (consumer) */
+} outq_t;
+
+#define UBXLOGBLK 65536 /* default block size of capture log index (bytes) */
+
+typedef struct
+{                        /* capture log index record type */
+    gtime_t time;        /* time of epoch frame (gpst) */
+    unsigned int offset; /* byte offset of epoch frame in capture file */
+    unsigned int len;    /* length of epoch frame (bytes) */
+    unsigned short type; /* message class/id of epoch frame */
+} ubxidx_t;
+typedef struct
+{                        /* capture log type */
+    FILE *fp;            /* capture file */
+    FILE *fpi;           /* index file (write) */
+    int mode;            /* open mode (0:read,1:write) */
+    int blksize;         /* block size (bytes) */
+    unsigned int offset; /* bytes written to capture file */
+    unsigned int blkend; /* end offset of indexed block */
+    ubxidx_t *index;     /* index records (read) */
+    int n;               /* number of index records (read) */
+} ubxlog_t;
+typedef struct
+{              /* geoid model context type */
+    int model; /* geoid model (GEOID_???) */
+    FILE *fp;  /* geoid model file (NULL: embedded model) */
+} geoid_t;
 typedef struct
 {
     gtime_t time;
@@ -737,13 +911,17 @@ typedef struct
     float qr[6];  // pos variance/covariance (m^2)
     /* {c_xx,c_yy,c_zz,c_xy,c_yz,c_zx} or */
     /* {c_ee,c_nn,c_uu,c_en,c_nu,c_ue} */
-    double dtr[6]; // receiver clock bias
+    double dtr[6]; // receiver clock bias/time offsets (s) ([5]: clock drift (s/s))
     uint8_t type;  // 0: xyz-ecef, 1:enu-baseline
     uint8_t stat;  // solution status
     uint8_t ns;    // number of valid satellites
     float age;     // age of differential (s)
     float ratio;   // for validation
-    int processTime;
+    int processTime; // latency from arrival of observation data to solution (us)
+    float chisq;     // chi-square test statistic (weighted residual square sum)
+    float wtest;     // max normalized residual of raim fde (0: not tested)
+    uint8_t exsat;   // satellite excluded by raim fde (0: none)
+    uint8_t niter;   // number of spp iterations of the epoch
     int encoder;
 } sol_t;
 typedef struct
@@ -805,6 +983,16 @@ typedef struct
     int errLen;
     prcopt_t opt;
 } rtk_t;
+typedef struct
+{                                                                          /* stream transport type */
+    void *(*open)(const char *path, int mode, char *msg);                  /* open (return: port, NULL: error) */
+    int (*read)(void *port, unsigned char *buff, int n, char *msg);        /* read available bytes (-1: error) */
+    int (*write)(void *port, const unsigned char *buff, int n, char *msg); /* write without wait (-1: error) */
+    int (*poll)(void *port, int tout);                                     /* wait for input (ms) (1: ready) */
+    void (*close)(void *port);                                             /* close */
+    unsigned int (*tick)(void *port);                                      /* arrival tick of last input (NULL: read tick) */
+} strdev_t;
+
 typedef struct
 {                             /* stream type */
     int type;                 /* type (STR_???) */
@@ -814,7 +1002,9 @@ typedef struct
     unsigned int outb, outr;  /* output bytes/rate */
     unsigned int tick, tact;  /* tick/active tick??/???? */
     unsigned int inbt, outbt; /* input/output bytes at tick?????/???? */
+    unsigned int tarr;        /* arrival tick of last input (tickcnt()) */
                               //    lock_t lock;        /* lock flag??? */
+    const strdev_t *dev;      /* stream transport */
     void *port;               /* type dependent port control struct??????????? */
                               //    char path[MAXSTRPATH]; /* stream path ?????*/
     char msg[MAXSTRMSG];      /* stream message ?????*/
@@ -836,6 +1026,7 @@ typedef struct
     stream_t stream[16]; /* input/output streams */
     strconv_t *conv[16]; /* stream converter */
     raw_t raw[2];
+    double dirp;         /* course of last moving solution for nmea rmc (deg) */
     //    thread_t thread;    /* server thread */
     //    lock_t lock;        /* lock flag */
 } strsvr_t;
@@ -845,8 +1036,43 @@ typedef struct
 /* receiver raw data functions */
 extern int input_raw(raw_t *raw, int format, unsigned char data);
 extern int input_rawf(raw_t *raw, int format, FILE *fp);
+extern int input_raw_block(raw_t *raw, int format, const unsigned char *buff,
+                           int n, rawfunc_t func);
 extern int init_raw(raw_t *raw);
+extern int push_rawevt(raw_t *raw, int type, int sat);
+extern int get_rawevt(raw_t *raw, rawevt_t *evt);
 extern int input_ubx(raw_t *raw, unsigned char data);
+extern int input_ubx_block(raw_t *raw, const unsigned char *buff, int n,
+                           rawfunc_t func);
+extern int input_ubxfrm(raw_t *raw, const unsigned char *frm, int len);
+extern void init_demux(demux_t *dmx, raw_t *raw);
+extern int input_demux(demux_t *dmx, const unsigned char *buff, int n);
+extern int init_ring(ring_t *ring, unsigned char *buff, unsigned int size);
+extern int put_ring(ring_t *ring, unsigned char data);
+extern int write_ring(ring_t *ring, const unsigned char *buff, int n);
+extern int peek_ring(ring_t *ring, const unsigned char **p);
+extern void skip_ring(ring_t *ring, int n);
+extern void init_outq(outq_t *q);
+extern unsigned char *alloc_outq(outq_t *q);
+extern void commit_outq(outq_t *q, int len);
+extern void write_outq(outq_t *q, const unsigned char *buff, int n);
+extern int peek_outq(outq_t *q, const unsigned char **p);
+extern void skip_outq(outq_t *q, int n);
+extern void strinit(stream_t *stream);
+extern int stropen(stream_t *stream, int type, int mode, const char *path);
+extern void strclose(stream_t *stream);
+extern int strread(stream_t *stream, unsigned char *buff, int n);
+extern int strwrite(stream_t *stream, const unsigned char *buff, int n);
+extern int strpoll(stream_t *stream, int tout);
+#ifdef STM32F767xx
+extern const strdev_t usart3_dev; /* receiver uart transport (usart3.c) */
+extern outq_t USART1_TX_Q;        /* console output record queue (usart.c) */
+extern void usart1_txstart(void); /* start console transmit interrupt (usart.c) */
+#endif
+extern int open_ubxlog(ubxlog_t *log, const char *file, int mode, int blksize);
+extern void close_ubxlog(ubxlog_t *log);
+extern int write_ubxlog(ubxlog_t *log, const unsigned char *frm, int len);
+extern unsigned int seek_ubxlog(ubxlog_t *log, gtime_t time);
 extern int decode_frame(const unsigned char *buff, eph_t *eph, alm_t *alm,
                         double *ion, double *utc, int *leaps);
 extern int decode_gal_inav(const unsigned char *buff, eph_t *eph);
@@ -856,6 +1082,11 @@ extern int test_glostr(const unsigned char *buff);
 extern int decode_glostr(const unsigned char *buff, geph_t *geph);
 // extern void free_raw  (raw_t *raw);
 extern int input_ubxf(raw_t *raw, FILE *fp);
+extern int outubxstat(unsigned char *buff, const raw_t *raw);
+extern int gen_ubx(const char *msg, unsigned char *buff);
+extern int init_ubxcfg(ubxcfg_t *cfg, const unsigned char *buff, int n,
+                       int window, unsigned int tout);
+extern int send_ubxcfg(ubxcfg_t *cfg, ubxwrite_t write, unsigned int tick);
 /* sbas functions*/
 extern int sbsdecodemsg(gtime_t time, int prn, const unsigned int *words,
                         sbsmsg_t *sbsmsg);
@@ -874,6 +1105,7 @@ extern gtime_t bdt2time(int week, double sec);
 extern gtime_t utc2gpst(gtime_t t);
 extern gtime_t timeadd(gtime_t t, double sec);
 extern double timediff(gtime_t t1, gtime_t t2);
+extern unsigned int tickcnt(void);
 extern int satsys(int sat, int *prn);
 extern void matcpy(double *A, const double *B, int n, int m);
 extern void ecef2pos(const double *r, double *pos);
@@ -929,7 +1161,7 @@ extern void satposs(gtime_t teph, const obsd_t *obs, int n, nav_t *nav,
                     int ephopt, double *rs, double *dts, double *var, int *svh);
 // solution
 extern void outsol(char *res, const sol_t *sol, const double *rb);
-extern int outnmea_rmc(unsigned char *buff, const sol_t *sol);
+extern int outnmea_rmc(unsigned char *buff, const sol_t *sol, double *dirp);
 extern int outnmea_gga(unsigned char *buff, const sol_t *sol);
 extern int outnmea_gsa(unsigned char *buff, const sol_t *sol,
                        const ssat_t *ssat);
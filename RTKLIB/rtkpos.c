@@ -100,12 +100,6 @@ extern int resamb_TCAR(rtk_t *rtk, const obsd_t *obs, const int *sat,
                        const double *azel) { return 0; }
 #endif
 
-/* global variables ----------------------------------------------------------*/
-static int statlevel = 0;         /* rtk status output level (0:off) */
-static FILE *fp_stat = NULL;      /* rtk status file pointer */
-static char file_stat[1024] = ""; /* rtk status file original path */
-static gtime_t time_stat = {0};   /* rtk status file time */
-
 void rtkinit(rtk_t *rtk, const prcopt_t *opt)
 {
     sol_t sol0 = {{0}};
@@ -64,7 +64,6 @@ extern int sbsdecodemsg(gtime_t time, int prn, const unsigned int *words,
     sbsmsg->msg[28]=(unsigned char)(words[7]>>18)&0xC0;
     for (i=28;i>0;i--) f[i]=(sbsmsg->msg[i]>>6)+(sbsmsg->msg[i-1]<<2);
     f[0]=sbsmsg->msg[0]>>6;
-    ublox_eph_flag=1;
     return crc24q(f,29)==(words[7]&0xFFFFFF); /* check crc */
 }
 
@@ -79,10 +79,15 @@ extern void outsol(char* res, const sol_t *sol, const double *rb)
 	res[0]='\n';		
 	
 }
-/* output solution in the form of nmea RMC sentence --------------------------*/
-extern int outnmea_rmc(unsigned char *buff, const sol_t *sol)
+/* output solution in the form of nmea RMC sentence ---------------------------
+* args   : unsigned char *buff IO output buffer
+*          sol_t  *sol    I     solution
+*          double *dirp   IO    course of last moving solution (deg) (output
+*                               as course of solution not moving)
+* return : number of output bytes
+*-----------------------------------------------------------------------------*/
+extern int outnmea_rmc(unsigned char *buff, const sol_t *sol, double *dirp)
 {
-    static double dirp=0.0;
     gtime_t time;
     double ep[6],pos[3],enuv[3],dms1[3],dms2[3],vel,dir,amag=0.0;
     char *p=(char *)buff,*q,sum,*emag="E";
@@ -104,10 +109,10 @@ extern int outnmea_rmc(unsigned char *buff, const sol_t *sol)
     if (vel>=1.0) {
         dir=atan2(enuv[0],enuv[1])*R2D;
         if (dir<0.0) dir+=360.0;
-        dirp=dir;
+        *dirp=dir;
     }
     else {
-        dir=dirp;
+        dir=*dirp;
     }
     deg2dms(fabs(pos[0])*R2D,dms1,7);
     deg2dms(fabs(pos[1])*R2D,dms2,7);
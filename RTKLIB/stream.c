@@ -0,0 +1,500 @@
+/*------------------------------------------------------------------------------
+ * stream.c : stream input/output functions
+ *
+ * description : stream_t reads and writes bytes through a transport
+ *               (strdev_t: open/read/write/poll/close) selected by the stream
+ *               type, so the decode, solve and output pipeline is independent
+ *               of the byte source. the transports of the platform are:
+ *
+ *               board (STM32F767xx):
+ *                 STR_SERIAL : receiver uart (usart3 receive ring)
+ *               linux:
+ *                 STR_SERIAL : serial port (termios)  port[:brate]
+ *                 STR_PTY    : pseudo-terminal        [link]
+ *                 STR_TCPSVR : tcp server             :port
+ *                 STR_TCPCLI : tcp client             addr:port
+ *                 STR_FILE   : file                   path ("-": stdin/stdout)
+ *
+ *               all transports are non-blocking. read returns the bytes
+ *               available (0: none) and strpoll() waits for input.
+ *               stdin/stdout ("-") are shared with the parent shell, so they
+ *               are not set to O_NONBLOCK but polled before read/write.
+ *
+ * history : 2026/10/17 1.0 new
+ *-----------------------------------------------------------------------------*/
+#ifdef __linux__
+#define _GNU_SOURCE /* posix_openpt(),cfmakeraw() */
+#endif
+#include "rtklib.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+typedef struct
+{              /* file descriptor port type */
+    int fd;    /* file descriptor (serial, pty, file, tcp client) */
+    int sock;  /* listening socket (tcp server) (-1: none) */
+    int owned; /* close fd at close (0: stdin/stdout) */
+} fdport_t;
+
+/* new file descriptor port ---------------------------------------------------*/
+static fdport_t *newport(int fd, int sock, int owned)
+{
+    fdport_t *port;
+
+    if (!(port = (fdport_t *)malloc(sizeof(fdport_t))))
+    {
+        if (fd >= 0 && owned)
+            close(fd);
+        if (sock >= 0)
+            close(sock);
+        return NULL;
+    }
+    port->fd = fd;
+    port->sock = sock;
+    port->owned = owned;
+    if (owned)
+        fcntl(fd >= 0 ? fd : sock, F_SETFL, fcntl(fd >= 0 ? fd : sock, F_GETFL) | O_NONBLOCK);
+    return port;
+}
+/* test file descriptor ready without wait (stdin/stdout: blocking) ----------*/
+static int readyfd(const fdport_t *port, short events)
+{
+    struct pollfd pfd;
+
+    if (port->owned)
+        return 1;
+    pfd.fd = port->fd;
+    pfd.events = events;
+    return poll(&pfd, 1, 0) > 0;
+}
+/* read/write file descriptor (return -1: end of stream or error) -----------*/
+static int readfd(void *p, unsigned char *buff, int n, char *msg)
+{
+    fdport_t *port = (fdport_t *)p;
+    ssize_t nr;
+
+    if (port->fd < 0 || !readyfd(port, POLLIN))
+        return 0;
+    if ((nr = read(port->fd, buff, n)) > 0)
+        return (int)nr;
+    if (nr < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return 0;
+    sprintf(msg, nr == 0 ? "end of stream" : "read error (%d)", errno);
+    return -1;
+}
+static int writefd(void *p, const unsigned char *buff, int n, char *msg)
+{
+    fdport_t *port = (fdport_t *)p;
+    ssize_t nw;
+
+    if (port->fd < 0 || !readyfd(port, POLLOUT))
+        return 0;
+    if ((nw = write(port->fd, buff, n)) >= 0)
+        return (int)nw;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        return 0;
+    sprintf(msg, "write error (%d)", errno);
+    return -1;
+}
+/* wait for input of file descriptor ------------------------------------------*/
+static int pollfd_(void *p, int tout)
+{
+    fdport_t *port = (fdport_t *)p;
+    struct pollfd pfd;
+
+    pfd.fd = port->fd >= 0 ? port->fd : port->sock;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, tout) > 0 ? 1 : 0;
+}
+static void closefd(void *p)
+{
+    fdport_t *port = (fdport_t *)p;
+
+    if (port->fd >= 0 && port->owned)
+        close(port->fd);
+    if (port->sock >= 0)
+        close(port->sock);
+    free(port);
+}
+/* set raw mode 8N1 to terminal -----------------------------------------------*/
+static int rawterm(int fd, speed_t speed)
+{
+    struct termios ios;
+
+    if (tcgetattr(fd, &ios) < 0)
+        return 0;
+    cfmakeraw(&ios);
+    ios.c_cflag |= CLOCAL | CREAD;
+    ios.c_cc[VMIN] = 0;
+    ios.c_cc[VTIME] = 0;
+    if (speed)
+    {
+        cfsetispeed(&ios, speed);
+        cfsetospeed(&ios, speed);
+    }
+    return tcsetattr(fd, TCSANOW, &ios) == 0;
+}
+/* open serial port (path: port[:brate]) --------------------------------------*/
+static void *openserial(const char *path, int mode, char *msg)
+{
+    const int br[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+    const speed_t bs[] = {B9600, B19200, B38400, B57600, B115200, B230400,
+                          B460800, B921600};
+    char port[256], *p;
+    int i, fd, brate = 115200;
+
+    sprintf(port, path[0] == '/' ? "%.255s" : "/dev/%.250s", path);
+    if ((p = strchr(port, ':')))
+    {
+        *p = '\0';
+        brate = atoi(p + 1);
+    }
+    for (i = 0; i < 8 && br[i] != brate; i++)
+        ;
+    if (i >= 8)
+    {
+        sprintf(msg, "bitrate error (%d)", brate);
+        return NULL;
+    }
+    if ((fd = open(port, (mode & STR_MODE_W ? O_RDWR : O_RDONLY) | O_NOCTTY)) < 0)
+    {
+        sprintf(msg, "device open error (%d): %s", errno, port);
+        return NULL;
+    }
+    if (!rawterm(fd, bs[i]))
+    {
+        sprintf(msg, "device setting error (%d): %s", errno, port);
+        close(fd);
+        return NULL;
+    }
+    return newport(fd, -1, 1);
+}
+/* open pseudo-terminal (path: link to slave device, "": none) ----------------*/
+static void *openpty_(const char *path, int mode, char *msg)
+{
+    const char *name;
+    int fd;
+
+    (void)mode;
+    if ((fd = posix_openpt(O_RDWR | O_NOCTTY)) < 0 || grantpt(fd) < 0 ||
+        unlockpt(fd) < 0 || !(name = ptsname(fd)) || !rawterm(fd, 0))
+    {
+        sprintf(msg, "pty open error (%d)", errno);
+        if (fd >= 0)
+            close(fd);
+        return NULL;
+    }
+    if (*path)
+    {
+        unlink(path);
+        if (symlink(name, path) < 0)
+        {
+            sprintf(msg, "pty link error (%d): %s", errno, path);
+            close(fd);
+            return NULL;
+        }
+    }
+    sprintf(msg, "%s", name);
+    return newport(fd, -1, 1);
+}
+/* read pseudo-terminal (no slave open: no data) ------------------------------*/
+static int readpty(void *p, unsigned char *buff, int n, char *msg)
+{
+    fdport_t *port = (fdport_t *)p;
+    ssize_t nr;
+
+    if ((nr = read(port->fd, buff, n)) > 0)
+        return (int)nr;
+    if (nr < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR &&
+        errno != EIO)
+    {
+        sprintf(msg, "read error (%d)", errno);
+        return -1;
+    }
+    return 0;
+}
+/* open tcp server (path: [:]port) --------------------------------------------*/
+static void *opentcpsvr(const char *path, int mode, char *msg)
+{
+    struct sockaddr_in addr;
+    int sock, opt = 1;
+
+    (void)mode;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((unsigned short)atoi(*path == ':' ? path + 1 : path));
+
+    if ((sock = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        sprintf(msg, "socket error (%d)", errno);
+        return NULL;
+    }
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 1) < 0)
+    {
+        sprintf(msg, "bind error (%d): %s", errno, path);
+        close(sock);
+        return NULL;
+    }
+    return newport(-1, sock, 1);
+}
+/* accept client of tcp server (one client, a new client replaces it) --------*/
+static void accepttcp(fdport_t *port)
+{
+    int fd, opt = 1;
+
+    if ((fd = accept(port->sock, NULL, NULL)) < 0)
+        return;
+    if (port->fd >= 0)
+        close(port->fd);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    port->fd = fd;
+}
+/* read/write tcp server (client disconnected: wait next client) -------------*/
+static int readtcpsvr(void *p, unsigned char *buff, int n, char *msg)
+{
+    fdport_t *port = (fdport_t *)p;
+    int nr;
+
+    accepttcp(port);
+    if ((nr = readfd(port, buff, n, msg)) < 0)
+    {
+        close(port->fd);
+        port->fd = -1;
+        return 0;
+    }
+    return nr;
+}
+static int writetcpsvr(void *p, const unsigned char *buff, int n, char *msg)
+{
+    fdport_t *port = (fdport_t *)p;
+    ssize_t nw;
+
+    (void)msg;
+    accepttcp(port);
+    if (port->fd < 0)
+        return 0;
+    if ((nw = send(port->fd, buff, n, MSG_NOSIGNAL)) >= 0)
+        return (int)nw;
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        close(port->fd);
+        port->fd = -1;
+    }
+    return 0;
+}
+/* wait for input or client of tcp server -------------------------------------*/
+static int polltcpsvr(void *p, int tout)
+{
+    fdport_t *port = (fdport_t *)p;
+    struct pollfd pfd[2];
+    int n = 0;
+
+    pfd[n].fd = port->sock;
+    pfd[n++].events = POLLIN;
+    if (port->fd >= 0)
+    {
+        pfd[n].fd = port->fd;
+        pfd[n++].events = POLLIN;
+    }
+    return poll(pfd, n, tout) > 0 ? 1 : 0;
+}
+/* open tcp client (path: addr:port) ------------------------------------------*/
+static void *opentcpcli(const char *path, int mode, char *msg)
+{
+    struct addrinfo hints, *res;
+    char addr[256], *p;
+    int fd, opt = 1;
+
+    (void)mode;
+    sprintf(addr, "%.255s", path);
+    if (!(p = strrchr(addr, ':')))
+    {
+        sprintf(msg, "port error: %s", path);
+        return NULL;
+    }
+    *p = '\0';
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(*addr ? addr : "localhost", p + 1, &hints, &res) != 0)
+    {
+        sprintf(msg, "address error: %s", path);
+        return NULL;
+    }
+    if ((fd = socket(res->ai_family, res->ai_socktype, 0)) < 0 ||
+        connect(fd, res->ai_addr, res->ai_addrlen) < 0)
+    {
+        sprintf(msg, "connect error (%d): %s", errno, path);
+        if (fd >= 0)
+            close(fd);
+        freeaddrinfo(res);
+        return NULL;
+    }
+    freeaddrinfo(res);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    return newport(fd, -1, 1);
+}
+/* open file (path: file path, "-": stdin/stdout) (read mode: input file) ---*/
+static void *openfile(const char *path, int mode, char *msg)
+{
+    int fd;
+
+    if (!strcmp(path, "-"))
+        return newport(mode & STR_MODE_R ? 0 : 1, -1, 0);
+
+    if ((fd = open(path, mode & STR_MODE_R ? O_RDONLY : O_WRONLY | O_CREAT | O_TRUNC,
+                   0644)) < 0)
+    {
+        sprintf(msg, "file open error (%d): %s", errno, path);
+        return NULL;
+    }
+    return newport(fd, -1, 1);
+}
+static const strdev_t serialdev = {openserial, readfd, writefd, pollfd_, closefd, NULL};
+static const strdev_t ptydev = {openpty_, readpty, writefd, pollfd_, closefd, NULL};
+static const strdev_t tcpsvrdev = {opentcpsvr, readtcpsvr, writetcpsvr, polltcpsvr, closefd, NULL};
+static const strdev_t tcpclidev = {opentcpcli, readfd, writefd, pollfd_, closefd, NULL};
+static const strdev_t filedev = {openfile, readfd, writefd, pollfd_, closefd, NULL};
+#endif /* __linux__ */
+
+/* transport of stream type (NULL: not supported) ----------------------------*/
+static const strdev_t *getdev(int type)
+{
+    switch (type)
+    {
+#if defined(STM32F767xx)
+    case STR_SERIAL:
+        return &usart3_dev;
+#elif defined(__linux__)
+    case STR_SERIAL:
+        return &serialdev;
+    case STR_PTY:
+        return &ptydev;
+    case STR_TCPSVR:
+        return &tcpsvrdev;
+    case STR_TCPCLI:
+        return &tcpclidev;
+    case STR_FILE:
+        return &filedev;
+#endif
+    }
+    return NULL;
+}
+/* initialize stream -----------------------------------------------------------
+ * args   : stream_t *stream IO stream
+ * return : none
+ *-----------------------------------------------------------------------------*/
+extern void strinit(stream_t *stream)
+{
+    memset(stream, 0, sizeof(stream_t));
+}
+/* open stream -----------------------------------------------------------------
+ * args   : stream_t *stream IO stream
+ *          int    type   I     stream type (STR_SERIAL,STR_PTY,STR_TCPSVR,
+ *                              STR_TCPCLI,STR_FILE)
+ *          int    mode   I     stream mode (STR_MODE_???)
+ *          char   *path  I     stream path (see description)
+ * return : status (1:ok,0:error)
+ * notes  : the error message or the device name (pty) is in stream->msg.
+ *-----------------------------------------------------------------------------*/
+extern int stropen(stream_t *stream, int type, int mode, const char *path)
+{
+    strinit(stream);
+    stream->type = type;
+    stream->mode = mode;
+
+    if (!(stream->dev = getdev(type)))
+    {
+        sprintf(stream->msg, "stream type not supported: %d", type);
+        stream->state = -1;
+        return 0;
+    }
+    if (!(stream->port = stream->dev->open(path, mode, stream->msg)))
+    {
+        stream->state = -1;
+        return 0;
+    }
+    stream->state = 1;
+    return 1;
+}
+/* close stream ----------------------------------------------------------------
+ * args   : stream_t *stream IO stream
+ * return : none
+ *-----------------------------------------------------------------------------*/
+extern void strclose(stream_t *stream)
+{
+    if (stream->dev && stream->port)
+        stream->dev->close(stream->port);
+    stream->port = NULL;
+    stream->state = 0;
+}
+/* read stream -----------------------------------------------------------------
+ * args   : stream_t *stream IO stream
+ *          unsigned char *buff O data buffer
+ *          int    n      I     size of data buffer (bytes)
+ * return : number of bytes read (0: no data)
+ * notes  : no wait for data. at end of stream or error, stream->state is set
+ *          to -1 and the message is in stream->msg.
+ *          the arrival tick of the last byte read is set to stream->tarr (the
+ *          tick of the transport, or the read tick if the transport has none).
+ *-----------------------------------------------------------------------------*/
+extern int strread(stream_t *stream, unsigned char *buff, int n)
+{
+    int nr;
+
+    if (stream->state <= 0 || !(stream->mode & STR_MODE_R))
+        return 0;
+    if ((nr = stream->dev->read(stream->port, buff, n, stream->msg)) < 0)
+    {
+        stream->state = -1;
+        return 0;
+    }
+    if (nr > 0)
+        stream->tarr = stream->dev->tick ? stream->dev->tick(stream->port) : tickcnt();
+    stream->inb += nr;
+    return nr;
+}
+/* write stream ----------------------------------------------------------------
+ * args   : stream_t *stream IO stream
+ *          unsigned char *buff I data
+ *          int    n      I     length of data (bytes)
+ * return : number of bytes written
+ * notes  : no wait for output. bytes not written are not buffered.
+ *-----------------------------------------------------------------------------*/
+extern int strwrite(stream_t *stream, const unsigned char *buff, int n)
+{
+    int nw;
+
+    if (stream->state <= 0 || !(stream->mode & STR_MODE_W))
+        return 0;
+    if ((nw = stream->dev->write(stream->port, buff, n, stream->msg)) < 0)
+    {
+        stream->state = -1;
+        return 0;
+    }
+    stream->outb += nw;
+    return nw;
+}
+/* wait for input of stream ----------------------------------------------------
+ * args   : stream_t *stream I  stream
+ *          int    tout   I     timeout (ms) (0: no wait)
+ * return : status (1:input ready,0:timeout)
+ *-----------------------------------------------------------------------------*/
+extern int strpoll(stream_t *stream, int tout)
+{
+    if (stream->state <= 0)
+        return 0;
+    return stream->dev->poll(stream->port, tout);
+}
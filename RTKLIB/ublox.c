@@ -31,6 +31,51 @@
 #define ID_RXMSFRB 0x0211  /* ubx message id: subframe buffer */
 #define ID_RXMSFRBX 0x0213 /* ubx message id: raw subframe data */
 #define ID_RXMRAWX 0x0215  /* ubx message id: multi-gnss raw meas data */
+#define ID_NAVPVT 0x0107   /* ubx message id: navigation pvt solution */
+#define ID_NAVCLOCK 0x0122 /* ubx message id: clock solution */
+#define ID_NAVSAT 0x0135   /* ubx message id: satellite information */
+#define ID_TIMTP 0x0D01    /* ubx message id: time pulse timedata */
+#define ID_ACKNAK 0x0500   /* ubx message id: message not acknowledged */
+#define ID_ACKACK 0x0501   /* ubx message id: message acknowledged */
+
+#ifndef ENAUBX_RXMRAW /* enable decoders (1:on,0:off, override by -D) */
+#define ENAUBX_RXMRAW 1
+#endif
+#ifndef ENAUBX_RXMRAWX
+#define ENAUBX_RXMRAWX 1
+#endif
+#ifndef ENAUBX_RXMSFRB
+#define ENAUBX_RXMSFRB 1
+#endif
+#ifndef ENAUBX_RXMSFRBX
+#define ENAUBX_RXMSFRBX 1
+#endif
+#ifndef ENAUBX_NAVPVT
+#define ENAUBX_NAVPVT 1
+#endif
+#ifndef ENAUBX_NAVCLOCK
+#define ENAUBX_NAVCLOCK 1
+#endif
+#ifndef ENAUBX_NAVSAT
+#define ENAUBX_NAVSAT 1
+#endif
+#ifndef ENAUBX_TIMTP
+#define ENAUBX_TIMTP 1
+#endif
+#ifndef ENAUBX_ACK
+#define ENAUBX_ACK 1
+#endif
+
+#ifndef UBXTICK /* decode time tick source (override by -D) */
+#if defined(STM32F767xx)
+#define UBXTICK() (DWT->CYCCNT) /* cpu cycles (enable DWT cycle counter) */
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UBXTICK() ((unsigned int)__builtin_ia32_rdtsc())
+#else
+#define UBXTICK() 0U
+#endif
+#endif
+#define MAXUBXSIG 10 /* max number of ubx signal id + 1 */
 
 #define FU1 1 /* ubx message field types */
 #define FU2 2
@@ -44,30 +89,40 @@
 
 #define CPSTD_VALID 5 /* std-dev threshold of carrier-phase valid */
 // static const char rcsid[]="$Id: ublox.c,v 1.2 2008/07/14 00:05:05 TTAKA Exp $";
-unsigned char ublox_raw_flag = 0;
-unsigned char ublox_eph_flag = 0;
 /* get fields (little-endian) ------------------------------------------------*/
 #define U1(p) (*((unsigned char *)(p)))
 #define I1(p) (*((char *)(p)))
-static unsigned short U2(unsigned char *p)
+static unsigned short U2(const unsigned char *p)
 {
     unsigned short u;
     memcpy(&u, p, 2);
     return u;
 }
-static unsigned int U4(unsigned char *p)
+static unsigned int U4(const unsigned char *p)
 {
     unsigned int u;
     memcpy(&u, p, 4);
     return u;
 }
-static float R4(unsigned char *p)
+static short I2(const unsigned char *p)
+{
+    short i;
+    memcpy(&i, p, 2);
+    return i;
+}
+static int I4(const unsigned char *p)
+{
+    int i;
+    memcpy(&i, p, 4);
+    return i;
+}
+static float R4(const unsigned char *p)
 {
     float r;
     memcpy(&r, p, 4);
     return r;
 }
-static double R8(unsigned char *p)
+static double R8(const unsigned char *p)
 {
     double r;
     memcpy(&r, p, 8);
@@ -85,7 +140,7 @@ static void setR4(unsigned char *p, float r) { memcpy(p, &r, 4); }
 static void setR8(unsigned char *p, double r) { memcpy(p, &r, 8); }
 
 /* checksum ------------------------------------------------------------------*/
-static int checksum(unsigned char *buff, int len)
+static int checksum(const unsigned char *buff, int len)
 {
     unsigned char cka = 0, ckb = 0;
     int i;
@@ -117,6 +172,37 @@ static int ubx_sys(int ind)
     }
     return 0;
 }
+/* ubx signal id to frequency index + 1 and obs code ------------------------*/
+static const unsigned char ubx_sigtbl[7][MAXUBXSIG][2] = {
+    /* gps  */ {{1, CODE_L1C}, {0, 0}, {0, 0}, {2, CODE_L2L}, {2, CODE_L2S},
+                {0, 0}, {3, CODE_L5I}, {3, CODE_L5Q}},
+    /* sbas */ {{1, CODE_L1C}},
+    /* gal  */ {{1, CODE_L1C}, {1, CODE_L1B}, {0, 0}, {3, CODE_L5I}, {3, CODE_L5Q},
+                {2, CODE_L7I}, {2, CODE_L7Q}},
+    /* bds  */ {{1, CODE_L1I}, {1, CODE_L1I}, {2, CODE_L7I}, {2, CODE_L7I}},
+    /* imes */ {{0, 0}},
+    /* qzss */ {{1, CODE_L1C}, {1, CODE_L1Z}, {0, 0}, {0, 0}, {2, CODE_L2S},
+                {2, CODE_L2L}, {0, 0}, {0, 0}, {3, CODE_L5I}, {3, CODE_L5Q}},
+    /* glo  */ {{1, CODE_L1C}, {0, 0}, {2, CODE_L2C}}};
+
+/* carrier frequency of signal (f: frequency index, fcn: glonass channel) ----*/
+static double sigfreq(int sys, int f, int fcn)
+{
+    static const double freq_gps[] = {FREQ1, FREQ2, FREQ5};
+    static const double freq_gal[] = {FREQ1, FREQ7, FREQ5};
+    static const double freq_cmp[] = {FREQ1_CMP, FREQ2_CMP, FREQ5};
+
+    switch (sys)
+    {
+    case SYS_GLO:
+        return f == 0 ? FREQ1_GLO + DFRQ1_GLO * fcn : FREQ2_GLO + DFRQ2_GLO * fcn;
+    case SYS_GAL:
+        return freq_gal[f];
+    case SYS_CMP:
+        return freq_cmp[f];
+    }
+    return freq_gps[f];
+}
 static void setcs(unsigned char *buff, int len)
 {
     unsigned char cka = 0, ckb = 0;
@@ -131,26 +217,31 @@ static void setcs(unsigned char *buff, int len)
     buff[len - 1] = ckb;
 }
 /* decode ublox rxm-raw: raw measurement data --------------------------------*/
-static int decode_rxmraw(raw_t *raw)
+static int decode_rxmraw(raw_t *raw, const unsigned char *frm, int len)
 {
     gtime_t time;
     double tow, tt, tadj = 0.0, toff = 0.0, tn;
     int i, j, prn, sat, n = 0, nsat, week;
-    unsigned char *p = raw->buff + 6;
+    const unsigned char *p = frm + 6;
     char *q, tstr[32];
 
-    //    printf("decode_rxmraw: len=%d\n",raw->len);
+    //    printf("decode_rxmraw: len=%d\n",len);
 
     /* time tag adjustment option (-TADJ) */
     //    if ((q=strstr(raw->opt,"-TADJ"))) {  //TAD
     //        sscanf(q,"-TADJ=%lf",&tadj);
     //    }
+    if (len < 8 + 8)
+    {
+        //        printf("ubx rxmraw length error: len=%d\n",len);
+        return -1;
+    }
     tow = U4(p);
     week = U2(p + 4);
     nsat = U1(p + 6);
-    if (raw->len < 12 + 24 * nsat)
+    if (len < 16 + 24 * nsat)
     {
-        //        printf("ubx rxmraw length error: len=%d nsat=%d\n",raw->len,nsat);
+        //        printf("ubx rxmraw length error: len=%d nsat=%d\n",len,nsat);
         return -1;
     }
     time = gpst2time(week, tow * 0.001);
@@ -209,26 +300,32 @@ static int decode_rxmraw(raw_t *raw)
     }
     raw->time = time;
     raw->obs.n = n;
-
-    ublox_raw_flag = 1;
     return 1;
 }
 /* decode ubx-rxm-rawx: multi-gnss raw measurement data (ref [3]) ------------*/
-static int decode_rxmrawx(raw_t *raw)
+static int decode_rxmrawx(raw_t *raw, const unsigned char *frm, int len)
 {
+    static const obsd_t data0 = {{0}};
     gtime_t time;
-    double tow, cp1, pr1, tadj = 0.0, toff = 0.0, freq, tn;
-    int i, j, sys, prn, sat, n = 0, nsat, week, tstat, lockt, slip, halfv, halfc, fcn, cpstd;
+    obsd_t *obs;
+    double tow, cp1, pr1, tadj = 0.0, toff = 0.0, tn;
+    int i, f, k, sys, gnss, sig, prn, sat, n = 0, nsat, week, tstat, lockt, slip, halfv, halfc, fcn, cpstd;
     int std_slip = 0;
+    unsigned char index[MAXSAT]; /* observation index + 1 by satellite (0: none) */
     // char *q;
-    unsigned char *p = raw->buff + 6;
+    const unsigned char *p = frm + 6;
 
-    // trace(4,"decode_rxmrawx: len=%d\n",raw->len);
+    // trace(4,"decode_rxmrawx: len=%d\n",len);
 
+    if (len < 8 + 16)
+    {
+        // trace(2,"ubx rxmrawx length error: len=%d\n",len);
+        return -1;
+    }
     nsat = U1(p + 11);
-    if (raw->len < 24 + 32 * nsat)
+    if (len < 24 + 32 * nsat)
     {
-        // trace(2,"ubx rxmrawx length error: len=%d nsat=%d\n",raw->len,nsat);
+        // trace(2,"ubx rxmrawx length error: len=%d nsat=%d\n",len,nsat);
         return -1;
     }
     tow = R8(p);
@@ -237,11 +334,11 @@ static int decode_rxmrawx(raw_t *raw)
 
     if (week == 0)
     {
-        // trace(3,"ubx rxmrawx week=0 error: len=%d nsat=%d\n",raw->len,nsat);
+        // trace(3,"ubx rxmrawx week=0 error: len=%d nsat=%d\n",len,nsat);
         return 0;
     }
     //    if (raw->outtype) {
-    //        sprintf(raw->msgtype,"UBX RXM-RAWX  (%4d): time=%s nsat=%d",raw->len,
+    //        sprintf(raw->msgtype,"UBX RXM-RAWX  (%4d): time=%s nsat=%d",len,
     //                time_str(time,2),U1(p+11));
     //    }
     /* time tag adjustment option (-TADJ) */
@@ -259,10 +356,11 @@ static int decode_rxmrawx(raw_t *raw)
         toff = (tn - floor(tn + 0.5)) * tadj;
         time = timeadd(time, -toff);
     }
-    for (i = 0, p += 16; i < nsat && i < MAXOBS; i++, p += 32)
-    {
+    memset(index, 0, sizeof(index));
 
-        if (!(sys = ubx_sys(U1(p + 20))))
+    for (i = 0, p += 16; i < nsat; i++, p += 32)
+    {
+        if (!(sys = ubx_sys(gnss = U1(p + 20))))
         {
             // trace(2,"ubx rxmrawx: system error\n");
             continue;
@@ -273,33 +371,48 @@ static int decode_rxmrawx(raw_t *raw)
             // trace(2,"ubx rxmrawx sat number error: sys=%2d prn=%2d\n",sys,prn);
             continue;
         }
+        sig = U1(p + 22); /* signal id (0 for protocol <27) */
+        if (sig >= MAXUBXSIG || !(f = ubx_sigtbl[gnss][sig][0]) || f > NFREQ)
+        {
+            continue; /* unsupported signal */
+        }
+        f--;
+
+        /* merge signals of the satellite to one observation record */
+        if (!(k = index[sat - 1]))
+        {
+            if (n >= MAXOBS)
+                continue;
+            raw->obs.data[n] = data0;
+            raw->obs.data[n].sat = sat;
+            raw->obs.data[n].time = time;
+            index[sat - 1] = k = ++n;
+        }
+        obs = raw->obs.data + k - 1;
+
         cpstd = U1(p + 28) & 15; /* carrier-phase std-dev */
         tstat = U1(p + 30);      /* tracking status */
         pr1 = tstat & 1 ? R8(p) : 0.0;
         cp1 = tstat & 2 ? R8(p + 8) : 0.0;
         if (cp1 == -0.5 || cpstd > CPSTD_VALID)
             cp1 = 0.0; /* invalid phase */
-        raw->obs.data[n].sat = sat;
-        raw->obs.data[n].time = time;
-        raw->obs.data[n].P[0] = pr1;
-        raw->obs.data[n].L[0] = cp1;
+        obs->P[f] = pr1;
+        obs->L[f] = cp1;
 
         /* offset by time tag adjustment */
         if (toff != 0.0)
         {
             fcn = (int)U1(p + 23) - 7;
-            freq = sys == SYS_CMP ? FREQ1_CMP : (sys == SYS_GLO ? FREQ1_GLO + DFRQ1_GLO * fcn : FREQ1);
-            raw->obs.data[n].P[0] -= toff * CLIGHT;
-            raw->obs.data[n].L[0] -= toff * freq;
+            obs->P[f] -= toff * CLIGHT;
+            obs->L[f] -= toff * sigfreq(sys, f, fcn);
         }
-        raw->obs.data[n].D[0] = R4(p + 16);
-        raw->obs.data[n].SNR[0] = U1(p + 26) * 4;
-        raw->obs.data[n].LLI[0] = 0;
-        raw->obs.data[n].code[0] =
-            sys == SYS_CMP ? CODE_L1I : (sys == SYS_GAL ? CODE_L1X : CODE_L1C);
+        obs->D[f] = R4(p + 16);
+        obs->SNR[f] = U1(p + 26) * 4;
+        obs->LLI[f] = 0;
+        obs->code[f] = ubx_sigtbl[gnss][sig][1];
 
         lockt = U2(p + 24); /* lock time count (ms) */
-        slip = lockt == 0 || lockt < raw->lockt[sat - 1][0] ? 1 : 0;
+        slip = lockt == 0 || lockt < raw->lockt[sat - 1][f] ? 1 : 0;
 #if 0
         if (std_slip>0) {
             slip|=(cpstd>=std_slip)?1:0; /* slip by std-dev of cp */
@@ -317,36 +430,51 @@ static int decode_rxmrawx(raw_t *raw)
         { /* carrier-phase valid */
 
             /* LLI: bit1=loss-of-lock,bit2=half-cycle-invalid */
-            raw->obs.data[n].LLI[0] |= slip ? LLI_SLIP : 0;
+            obs->LLI[f] |= slip ? LLI_SLIP : 0;
 #if 0
-            raw->obs.data[n].LLI[0]|=halfc!=raw->halfc[sat-1][0]?1:0;
+            obs->LLI[f]|=halfc!=raw->halfc[sat-1][f]?1:0;
 #elif 1
-            raw->obs.data[n].LLI[0] |= halfc ? LLI_HALFA : 0; /* half-cycle subtraced */
+            obs->LLI[f] |= halfc ? LLI_HALFA : 0; /* half-cycle subtraced */
 #else
-            raw->obs.data[n].LLI[0] |= halfc ? LLI_HALFS : 0; /* half-cycle subtraced */
+            obs->LLI[f] |= halfc ? LLI_HALFS : 0; /* half-cycle subtraced */
 #endif
-            raw->obs.data[n].LLI[0] |= halfv ? 0 : LLI_HALFC;
-            raw->lockt[sat - 1][0] = lockt;
-            raw->halfc[sat - 1][0] = halfc;
+            obs->LLI[f] |= halfv ? 0 : LLI_HALFC;
+            raw->lockt[sat - 1][f] = lockt;
+            raw->halfc[sat - 1][f] = halfc;
         }
-        for (j = 1; j < NFREQ + NEXOBS; j++)
-        {
-            raw->obs.data[n].L[j] = raw->obs.data[n].P[j] = 0.0;
-            raw->obs.data[n].D[j] = 0.0;
-            raw->obs.data[n].SNR[j] = raw->obs.data[n].LLI[j] = 0;
-            raw->obs.data[n].code[j] = CODE_NONE;
-        }
-        n++;
     }
     raw->time = time;
     raw->obs.n = n;
-    ublox_raw_flag = 1;
     return 1;
 }
-/* save subframe -------------------------------------------------------------*/
-static int save_subfrm(int sat, raw_t *raw)
+/* subframe assembly buffer of satellite -------------------------------------*/
+static unsigned char *navbuff(raw_t *raw, int sat)
+{
+    subfrm_t *s = &raw->subfrm;
+    int prn;
+
+    switch (satsys(sat, &prn))
+    {
+    case SYS_GPS:
+        return s->gps[prn - MINPRNGPS];
+    case SYS_QZS:
+        return s->gps[NSATGPS + prn - MINPRNQZS];
+    case SYS_GLO:
+        return s->glo[prn - MINPRNGLO];
+    case SYS_GAL:
+        return s->gal[prn - MINPRNGAL];
+    case SYS_CMP:
+        return prn - MINPRNCMP < NSATBDSGEO ? s->geo[prn - MINPRNCMP]
+                                            : s->bds[prn - MINPRNCMP - NSATBDSGEO];
+    }
+    return NULL;
+}
+/* save subframe (subframe 4-5 to buff) --------------------------------------*/
+static int save_subfrm(int sat, raw_t *raw, const unsigned char *frm,
+                       unsigned char *buff)
 {
-    unsigned char *p = raw->buff + 6, *q;
+    const unsigned char *p = frm + 6;
+    unsigned char *q;
     int i, j, n, id = (U4(p + 6) >> 2) & 0x7;
 
     //    printf("save_subfrm: sat=%2d id=%d\n",sat,id);
@@ -354,7 +482,13 @@ static int save_subfrm(int sat, raw_t *raw)
     if (id < 1 || 5 < id)
         return 0;
 
-    q = raw->subfrm[sat - 1] + (id - 1) * 30;
+    if (id <= 3)
+    {
+        q = navbuff(raw, sat) + (id - 1) * 30;
+        raw->subfrm.mask[sat - 1] |= 1 << (id - 1);
+    }
+    else
+        q = buff;
 
     for (i = n = 0, p += 2; i < 10; i++, p += 4)
     {
@@ -367,18 +501,53 @@ static int save_subfrm(int sat, raw_t *raw)
     }
     return id;
 }
+/* navigation data fingerprint (fnv-1a of ephemeris key fields) --------------*/
+static unsigned int navfp(const unsigned int *key, int n)
+{
+    unsigned int fp = 2166136261u;
+    int i;
+
+    for (i = 0; i < n; i++)
+        fp = (fp ^ key[i]) * 16777619u;
+    return fp | 1; /* 0: no fingerprint */
+}
+/* test unchanged navigation data by fingerprint -----------------------------
+ * the key fields are those compared by the unchanged ephemeris tests, so a
+ * matching fingerprint means full decoding would return 0 (unchanged)
+ *-----------------------------------------------------------------------------*/
+static int skipnav(raw_t *raw, int sat, unsigned int fp)
+{
+    if (raw->ephfp[sat - 1] == fp)
+    {
+        raw->nnav[1]++;
+        return 1;
+    }
+    raw->nnav[0]++;
+    return 0;
+}
 /* decode ephemeris ----------------------------------------------------------*/
 static int decode_ephem(int sat, raw_t *raw)
 {
     eph_t eph = {0};
+    unsigned char *q = navbuff(raw, sat);
+    unsigned int key[1], fp;
 
     //    printf("decode_ephem: sat=%2d\n",sat);
 
-    if (decode_frame(raw->subfrm[sat - 1], &eph, NULL, NULL, NULL, NULL) != 1 ||
-        decode_frame(raw->subfrm[sat - 1] + 30, &eph, NULL, NULL, NULL, NULL) != 2 ||
-        decode_frame(raw->subfrm[sat - 1] + 60, &eph, NULL, NULL, NULL, NULL) != 3)
+    if ((raw->subfrm.mask[sat - 1] & 0x7) != 0x7)
+        return 0;
+
+    key[0] = getbitu(q + 60, 216, 8); /* iode */
+    if (skipnav(raw, sat, fp = navfp(key, 1)))
         return 0;
 
+    if (decode_frame(q, &eph, NULL, NULL, NULL, NULL) != 1 ||
+        decode_frame(q + 30, &eph, NULL, NULL, NULL, NULL) != 2 ||
+        decode_frame(q + 60, &eph, NULL, NULL, NULL, NULL) != 3)
+        return 0;
+
+    raw->ephfp[sat - 1] = fp;
+
     //    if (!strstr(raw->opt,"-EPHALL")) {
     if (eph.iode == raw->nav.eph[sat - 1].iode)
         return 0; /* unchanged */
@@ -386,38 +555,36 @@ static int decode_ephem(int sat, raw_t *raw)
     eph.sat = sat;
     raw->nav.eph[sat - 1] = eph;
     raw->ephsat = sat;
-    ublox_eph_flag = 1;
     return 2;
 }
-/* decode almanac and ion/utc ------------------------------------------------*/
-static int decode_alm1(int sat, raw_t *raw)
+/* decode almanac and ion/utc (subframe 4) -----------------------------------*/
+static int decode_alm1(raw_t *raw, const unsigned char *buff)
 {
-    //    printf("decode_alm1 : sat=%2d\n",sat);
-    decode_frame(raw->subfrm[sat - 1] + 90, NULL, raw->nav.alm, raw->nav.ion_gps,
+    //    printf("decode_alm1\n");
+    decode_frame(buff, NULL, raw->nav.alm, raw->nav.ion_gps,
                  raw->nav.utc_gps, &raw->nav.leaps);
-    ublox_eph_flag = 1;
-    return 0;
+    return 9;
 }
-/* decode almanac ------------------------------------------------------------*/
-static int decode_alm2(int sat, raw_t *raw)
+/* decode almanac (subframe 5) -----------------------------------------------*/
+static int decode_alm2(raw_t *raw, const unsigned char *buff)
 {
-    //    printf("decode_alm2 : sat=%2d\n",sat);
-    decode_frame(raw->subfrm[sat - 1] + 120, NULL, raw->nav.alm, NULL, NULL, NULL);
-    ublox_eph_flag = 1;
+    //    printf("decode_alm2\n");
+    decode_frame(buff, NULL, raw->nav.alm, NULL, NULL, NULL);
     return 0;
 }
 /* decode ublox rxm-sfrb: subframe buffer ------------------------------------*/
-static int decode_rxmsfrb(raw_t *raw)
+static int decode_rxmsfrb(raw_t *raw, const unsigned char *frm, int len)
 {
     unsigned int words[10];
+    unsigned char buff[30];
     int i, prn, sat, sys, id;
-    unsigned char *p = raw->buff + 6;
+    const unsigned char *p = frm + 6;
 
-    //    printf("decode_rxmsfrb: len=%d\n",raw->len);
+    //    printf("decode_rxmsfrb: len=%d\n",len);
 
-    if (raw->len < 42)
+    if (len < 42)
     {
-        //        printf("ubx rxmsfrb length error: len=%d\n",raw->len);
+        //        printf("ubx rxmsfrb length error: len=%d\n",len);
         return -1;
     }
     prn = U1(p + 1);
@@ -430,13 +597,13 @@ static int decode_rxmsfrb(raw_t *raw)
 
     if (sys == SYS_GPS)
     {
-        id = save_subfrm(sat, raw);
+        id = save_subfrm(sat, raw, frm, buff);
         if (id == 3)
             return decode_ephem(sat, raw);
         if (id == 4)
-            return decode_alm1(sat, raw);
+            return decode_alm1(raw, buff);
         if (id == 5)
-            return decode_alm2(sat, raw);
+            return decode_alm2(raw, buff);
         return 0;
     }
     else if (sys == SYS_SBS)
@@ -445,19 +612,20 @@ static int decode_rxmsfrb(raw_t *raw)
             words[i] = U4(p);
         return sbsdecodemsg(raw->time, prn, words, &raw->sbsmsg) ? 3 : 0;
     }
-    ublox_eph_flag = 1;
     return 0;
 }
 /* decode gps and qzss navigation data ---------------------------------------*/
-static int decode_nav(raw_t *raw, int sat, int off)
+static int decode_nav(raw_t *raw, const unsigned char *frm, int len, int sat,
+                      int off)
 {
     unsigned int words[10];
+    unsigned char buff[30], *q;
     int i, id;
-    unsigned char *p = raw->buff + 6 + off;
+    const unsigned char *p = frm + 6 + off;
 
-    if (raw->len < 48 + off)
+    if (len < 48 + off)
     {
-        // trace(2,"ubx rawsfrbx length error: sat=%d len=%d\n",sat,raw->len);
+        // trace(2,"ubx rawsfrbx length error: sat=%d len=%d\n",sat,len);
         return -1;
     }
     for (i = 0; i < 10; i++, p += 4)
@@ -469,28 +637,39 @@ static int decode_nav(raw_t *raw, int sat, int off)
         // trace(2,"ubx rawsfrbx subfrm id error: sat=%2d\n",sat);
         return -1;
     }
+    if (id <= 3)
+    {
+        q = navbuff(raw, sat) + (id - 1) * 30;
+        raw->subfrm.mask[sat - 1] |= 1 << (id - 1);
+    }
+    else
+        q = buff;
+
     for (i = 0; i < 10; i++)
     {
-        setbitu(raw->subfrm[sat - 1] + (id - 1) * 30, i * 24, 24, words[i]);
+        setbitu(q, i * 24, 24, words[i]);
     }
     if (id == 3)
         return decode_ephem(sat, raw);
     if (id == 4)
-        return decode_alm1(sat, raw);
+        return decode_alm1(raw, buff);
     if (id == 5)
-        return decode_alm2(sat, raw);
+        return decode_alm2(raw, buff);
     return 0;
 }
 /* decode galileo navigation data --------------------------------------------*/
-static int decode_enav(raw_t *raw, int sat, int off)
+static int decode_enav(raw_t *raw, const unsigned char *frm, int len, int sat,
+                       int off)
 {
     eph_t eph = {0};
-    unsigned char *p = raw->buff + 6 + off, buff[32], crc_buff[26] = {0};
+    const unsigned char *p = frm + 6 + off;
+    unsigned char buff[32], crc_buff[26] = {0}, *q;
+    unsigned int key[4], fp;
     int i, j, k, part1, page1, part2, page2, type;
 
-    if (raw->len < 44 + off)
+    if (len < 44 + off)
     {
-        // trace(2,"ubx rawsfrbx length error: sat=%d len=%d\n",sat,raw->len);
+        // trace(2,"ubx rawsfrbx length error: sat=%d len=%d\n",sat,len);
         return -1;
     }
     for (i = k = 0; i < 8; i++, p += 4)
@@ -531,22 +710,31 @@ static int decode_enav(raw_t *raw, int sat, int off)
 
     /* clear word 0-6 flags */
     if (type == 2)
-        raw->subfrm[sat - 1][112] = 0;
+        raw->subfrm.mask[sat - 1] = 0;
 
     /* save page data (112 + 16 bits) to frame buffer */
+    q = navbuff(raw, sat);
     k = type * 16;
     for (i = 0, j = 2; i < 14; i++, j += 8)
-        raw->subfrm[sat - 1][k++] = getbitu(buff, j, 8);
+        q[k++] = getbitu(buff, j, 8);
     for (i = 0, j = 2; i < 2; i++, j += 8)
-        raw->subfrm[sat - 1][k++] = getbitu(buff + 16, j, 8);
+        q[k++] = getbitu(buff + 16, j, 8);
 
     /* test word 0-6 flags */
-    raw->subfrm[sat - 1][112] |= (1 << type);
-    if (raw->subfrm[sat - 1][112] != 0x7F)
+    raw->subfrm.mask[sat - 1] |= (1 << type);
+    if (raw->subfrm.mask[sat - 1] != 0x7F)
+        return 0;
+
+    /* skip unchanged ephemeris by iod_nav, toe, toc and week */
+    key[0] = getbitu(q, 128 + 6, 10);
+    key[1] = getbitu(q, 128 + 16, 14);
+    key[2] = getbitu(q, 128 * 4 + 54, 14);
+    key[3] = getbitu(q, 96, 12);
+    if (skipnav(raw, sat, fp = navfp(key, 4)))
         return 0;
 
     /* decode galileo inav ephemeris */
-    if (!decode_gal_inav(raw->subfrm[sat - 1], &eph))
+    if (!decode_gal_inav(q, &eph))
     {
         return 0;
     }
@@ -556,6 +744,7 @@ static int decode_enav(raw_t *raw, int sat, int off)
         // trace(2,"ubx rawsfrbx gal svid error: sat=%2d %2d\n",sat,eph.sat);
         return -1;
     }
+    raw->ephfp[sat - 1] = fp;
     //    if (!strstr(raw->opt,"-EPHALL")) {
     if (eph.iode == raw->nav.eph[sat - 1].iode && /* unchanged */
         timediff(eph.toe, raw->nav.eph[sat - 1].toe) == 0.0 &&
@@ -568,16 +757,18 @@ static int decode_enav(raw_t *raw, int sat, int off)
     return 2;
 }
 /* decode beidou navigation data ---------------------------------------------*/
-static int decode_cnav(raw_t *raw, int sat, int off)
+static int decode_cnav(raw_t *raw, const unsigned char *frm, int len, int sat,
+                       int off)
 {
     eph_t eph = {0};
-    unsigned int words[10];
-    int i, id, pgn, prn;
-    unsigned char *p = raw->buff + 6 + off;
+    unsigned int words[10], key[6], fp;
+    int i, n, id, pgn, prn;
+    const unsigned char *p = frm + 6 + off;
+    unsigned char *q = navbuff(raw, sat);
 
-    if (raw->len < 48 + off)
+    if (len < 48 + off)
     {
-        //        trace(2,"ubx rawsfrbx length error: sat=%d len=%d\n",sat,raw->len);
+        //        trace(2,"ubx rawsfrbx length error: sat=%d len=%d\n",sat,len);
         return -1;
     }
     for (i = 0; i < 10; i++, p += 4)
@@ -590,19 +781,28 @@ static int decode_cnav(raw_t *raw, int sat, int off)
         //      trace(2,"ubx rawsfrbx subfrm id error: sat=%2d\n",sat);
         return -1;
     }
-    if (prn > 5)
+    if (prn > NSATBDSGEO)
     { /* IGSO/MEO */
 
+        if (id > 3)
+            return 0; /* subframe 4-5: almanac */
+
         for (i = 0; i < 10; i++)
         {
-            setbitu(raw->subfrm[sat - 1] + (id - 1) * 38, i * 30, 30, words[i]);
+            setbitu(q + (id - 1) * 38, i * 30, 30, words[i]);
         }
-        if (id != 3)
+        raw->subfrm.mask[sat - 1] |= 1 << (id - 1);
+        if (id != 3 || (raw->subfrm.mask[sat - 1] & 0x7) != 0x7)
             return 0;
 
-        /* decode beidou D1 ephemeris */
-        if (!decode_bds_d1(raw->subfrm[sat - 1], &eph))
-            return 0;
+        /* aode, aodc, week and toe of subframe 1-3 */
+        key[0] = getbitu(q, 287, 5);
+        key[1] = getbitu(q, 43, 5);
+        key[2] = getbitu(q, 60, 13);
+        key[3] = getbitu(q, 304 + 290, 2);
+        key[4] = getbitu(q, 608 + 42, 10);
+        key[5] = getbitu(q, 608 + 60, 5);
+        n = 6;
     }
     else
     { /* GEO */
@@ -618,15 +818,28 @@ static int decode_cnav(raw_t *raw, int sat, int off)
         }
         for (i = 0; i < 10; i++)
         {
-            setbitu(raw->subfrm[sat - 1] + (pgn - 1) * 38, i * 30, 30, words[i]);
+            setbitu(q + (pgn - 1) * 38, i * 30, 30, words[i]);
         }
-        if (pgn != 10)
-            return 0;
-
-        /* decode beidou D2 ephemeris */
-        if (!decode_bds_d2(raw->subfrm[sat - 1], &eph))
-            return 0;
+        raw->subfrm.mask[sat - 1] |= 1 << (pgn - 1);
+        if (pgn != 10 || (raw->subfrm.mask[sat - 1] & 0x3FD) != 0x3FD)
+            return 0; /* page 1,3-10 */
+
+        /* aodc, week of page 1, aode of page 4 and toe of page 7 */
+        key[0] = getbitu(q, 47, 5);
+        key[1] = getbitu(q, 64, 13);
+        key[2] = getbitu(q, 304 * 3 + 91, 5);
+        key[3] = getbitu(q, 304 * 6 + 80, 2);
+        key[4] = getbitu(q, 304 * 6 + 90, 15);
+        n = 5;
     }
+    if (skipnav(raw, sat, fp = navfp(key, n)))
+        return 0;
+
+    /* decode beidou D1/D2 ephemeris */
+    if (!(prn > NSATBDSGEO ? decode_bds_d1(q, &eph) : decode_bds_d2(q, &eph)))
+        return 0;
+
+    raw->ephfp[sat - 1] = fp;
     //    if (!strstr(raw->opt,"-EPHALL")) {
     if (timediff(eph.toe, raw->nav.eph[sat - 1].toe) == 0.0 &&
         eph.iode == raw->nav.eph[sat - 1].iode &&
@@ -639,17 +852,20 @@ static int decode_cnav(raw_t *raw, int sat, int off)
     return 2;
 }
 /* decode glonass navigation data --------------------------------------------*/
-static int decode_gnav(raw_t *raw, int sat, int off, int frq)
+static int decode_gnav(raw_t *raw, const unsigned char *frm, int len, int sat,
+                       int off, int frq)
 {
     geph_t geph = {0};
+    unsigned int key[1], fp;
     int i, j, k, m, prn;
-    unsigned char *p = raw->buff + 6 + off, buff[64], *fid;
+    const unsigned char *p = frm + 6 + off;
+    unsigned char buff[64], *q, *fid;
 
     satsys(sat, &prn);
 
-    if (raw->len < 24 + off)
+    if (len < 24 + off)
     {
-        // trace(2,"ubx rawsfrbx gnav length error: len=%d\n",raw->len);
+        // trace(2,"ubx rawsfrbx gnav length error: len=%d\n",len);
         return -1;
     }
     for (i = k = 0; i < 4; i++, p += 4)
@@ -670,23 +886,33 @@ static int decode_gnav(raw_t *raw, int sat, int off, int frq)
         return -1;
     }
     /* flush frame buffer if frame-id changed */
-    fid = raw->subfrm[sat - 1] + 150;
+    q = navbuff(raw, sat);
+    fid = q + 40;
     if (fid[0] != buff[12] || fid[1] != buff[13])
     {
-        for (i = 0; i < 4; i++)
-            memset(raw->subfrm[sat - 1] + i * 10, 0, 10);
+        memset(q, 0, 40);
         memcpy(fid, buff + 12, 2); /* save frame-id */
+        raw->subfrm.mask[sat - 1] = 0;
     }
-    memcpy(raw->subfrm[sat - 1] + (m - 1) * 10, buff, 10);
+    if (m > 4)
+        return 0; /* string 5-15: almanac */
+
+    memcpy(q + (m - 1) * 10, buff, 10);
+    raw->subfrm.mask[sat - 1] |= 1 << (m - 1);
+
+    if (m != 4 || raw->subfrm.mask[sat - 1] != 0xF)
+        return 0;
 
-    if (m != 4)
+    key[0] = getbitu(q, 89, 7); /* tb */
+    if (skipnav(raw, sat, fp = navfp(key, 1)))
         return 0;
 
     /* decode glonass ephemeris strings */
     geph.tof = raw->time;
-    if (!decode_glostr(raw->subfrm[sat - 1], &geph) || geph.sat != sat)
+    if (!decode_glostr(q, &geph) || geph.sat != sat)
         return 0;
     geph.frq = frq - 7;
+    raw->ephfp[sat - 1] = fp;
 
     //    if (!strstr(raw->opt,"-EPHALL")) {
     if (geph.iode == raw->nav.geph[prn - 1].iode)
@@ -697,14 +923,16 @@ static int decode_gnav(raw_t *raw, int sat, int off, int frq)
     return 2;
 }
 /* decode sbas navigation data -----------------------------------------------*/
-static int decode_snav(raw_t *raw, int sat, int off)
+static int decode_snav(raw_t *raw, const unsigned char *frm, int len, int sat,
+                       int off)
 {
     int i, j, k, prn, tow, week;
-    unsigned char *p = raw->buff + 6 + off, buff[64];
+    const unsigned char *p = frm + 6 + off;
+    unsigned char buff[64];
 
-    if (raw->len < 40 + off)
+    if (len < 40 + off)
     {
-        // trace(2,"ubx rawsfrbx snav length error: len=%d\n",raw->len);
+        // trace(2,"ubx rawsfrbx snav length error: len=%d\n",len);
         return -1;
     }
     tow = (int)time2gpst(timeadd(raw->time, -1.0), &week);
@@ -722,17 +950,22 @@ static int decode_snav(raw_t *raw, int sat, int off)
     return 3;
 }
 /* decode ubx-rxm-sfrbx: raw subframe data (ref [3]) -------------------------*/
-static int decode_rxmsfrbx(raw_t *raw)
+static int decode_rxmsfrbx(raw_t *raw, const unsigned char *frm, int len)
 {
     int prn, sat, sys;
-    unsigned char *p = raw->buff + 6;
+    const unsigned char *p = frm + 6;
 
-    // trace(4,"decode_rxmsfrbx: len=%d\n",raw->len);
+    // trace(4,"decode_rxmsfrbx: len=%d\n",len);
 
     //    if (raw->outtype) {
-    //        sprintf(raw->msgtype,"UBX RXM-SFRBX (%4d): sys=%d prn=%3d",raw->len,
+    //        sprintf(raw->msgtype,"UBX RXM-SFRBX (%4d): sys=%d prn=%3d",len,
     //                U1(p),U1(p+1));
     //    }
+    if (len < 8 + 8)
+    {
+        // trace(2,"ubx rxmsfrbx length error: len=%d\n",len);
+        return -1;
+    }
     if (!(sys = ubx_sys(U1(p))))
     {
         // trace(2,"ubx rxmsfrbx sys id error: sys=%d\n",U1(p));
@@ -747,49 +980,391 @@ static int decode_rxmsfrbx(raw_t *raw)
     switch (sys)
     {
     case SYS_GPS:
-        return decode_nav(raw, sat, 8);
+        return decode_nav(raw, frm, len, sat, 8);
     case SYS_QZS:
-        return decode_nav(raw, sat, 8);
+        return decode_nav(raw, frm, len, sat, 8);
     case SYS_GAL:
-        return decode_enav(raw, sat, 8);
+        return decode_enav(raw, frm, len, sat, 8);
     case SYS_CMP:
-        return decode_cnav(raw, sat, 8);
+        return decode_cnav(raw, frm, len, sat, 8);
     case SYS_GLO:
-        return decode_gnav(raw, sat, 8, U1(p + 3));
+        return decode_gnav(raw, frm, len, sat, 8, U1(p + 3));
     case SYS_SBS:
-        return decode_snav(raw, sat, 8);
+        return decode_snav(raw, frm, len, sat, 8);
     }
     return 0;
 }
-/* decode ublox raw message --------------------------------------------------*/
-static int decode_ubx(raw_t *raw)
+/* adjust gps week by time of week (ref: message or receiver solution time) --*/
+static int adjweek(const raw_t *raw, double tow, gtime_t *time)
+{
+    gtime_t t0 = raw->time.time ? raw->time : raw->rsol.time;
+    double tow_p;
+    int week;
+
+    if (t0.time == 0)
+        return 0;
+    tow_p = time2gpst(t0, &week);
+    if (tow < tow_p - 302400.0)
+        tow += 604800.0;
+    else if (tow > tow_p + 302400.0)
+        tow -= 604800.0;
+    *time = gpst2time(week, tow);
+    return 1;
+}
+#if ENAUBX_NAVPVT
+/* decode ubx-nav-pvt: navigation pvt solution -------------------------------*/
+static int decode_navpvt(raw_t *raw, const unsigned char *frm, int len)
 {
-    int type = (U1(raw->buff + 2) << 8) + U1(raw->buff + 3);
+    rcvsol_t *rsol = &raw->rsol;
+    const unsigned char *p = frm + 6;
+    double ep[6], pos[3], E[9], enu[3];
 
-    //   printf("decode_ubx: type=%04x len=%d\n",type,raw->len);
+    if (len < 100)
+    {
+        //        trace(2,"ubx navpvt length error: len=%d\n",len);
+        return -1;
+    }
+    /* utc date/time valid */
+    if ((U1(p + 11) & 0x03) != 0x03)
+        return 0;
+
+    ep[0] = U2(p + 4);
+    ep[1] = U1(p + 6);
+    ep[2] = U1(p + 7);
+    ep[3] = U1(p + 8);
+    ep[4] = U1(p + 9);
+    ep[5] = U1(p + 10) + I4(p + 16) * 1E-9;
+    rsol->time = utc2gpst(epoch2time(ep));
+    rsol->stat = (U1(p + 21) & 0x01) ? U1(p + 20) : 0; /* gnssFixOK */
+    rsol->ns = U1(p + 23);
+
+    if (rsol->stat < 2 || rsol->stat == 5)
+        return 5;
+    pos[0] = I4(p + 28) * 1E-7 * D2R;
+    pos[1] = I4(p + 24) * 1E-7 * D2R;
+    pos[2] = I4(p + 32) * 1E-3;
+    pos2ecef(pos, rsol->rr);
+
+    /* ned velocity to ecef */
+    enu[0] = I4(p + 52) * 1E-3;
+    enu[1] = I4(p + 48) * 1E-3;
+    enu[2] = -I4(p + 56) * 1E-3;
+    xyz2enu(pos, E);
+    matmul("TN", 3, 1, 3, 1.0, E, enu, 0.0, rsol->rr + 3);
+    return 5;
+}
+#endif
+#if ENAUBX_NAVCLOCK
+/* decode ubx-nav-clock: clock solution --------------------------------------*/
+static int decode_navclock(raw_t *raw, const unsigned char *frm, int len)
+{
+    rcvsol_t *rsol = &raw->rsol;
+    const unsigned char *p = frm + 6;
+
+    if (len < 28)
+    {
+        //        trace(2,"ubx navclock length error: len=%d\n",len);
+        return -1;
+    }
+    if (!adjweek(raw, U4(p) * 1E-3, &rsol->tclk))
+        return 0;
+    rsol->dtr[0] = I4(p + 4) * 1E-9;
+    rsol->dtr[1] = I4(p + 8) * 1E-9;
+    return 6;
+}
+#endif
+#if ENAUBX_NAVSAT
+/* decode ubx-nav-sat: satellite information ---------------------------------*/
+static int decode_navsat(raw_t *raw, const unsigned char *frm, int len)
+{
+    rcvsol_t *rsol = &raw->rsol;
+    const unsigned char *p = frm + 6;
+    int i, n, sys, prn, sat;
+
+    if (len < 8 + 8)
+    {
+        //        trace(2,"ubx navsat length error: len=%d\n",len);
+        return -1;
+    }
+    n = U1(p + 5);
+    if (len < 16 + n * 12)
+    {
+        //        trace(2,"ubx navsat length error: len=%d nsat=%d\n",len,n);
+        return -1;
+    }
+    if (!adjweek(raw, U4(p) * 1E-3, &rsol->tsat))
+        return 0;
+
+    memset(rsol->cno, 0, sizeof(rsol->cno));
+    memset(rsol->vsat, 0, sizeof(rsol->vsat));
+
+    for (i = 0, p += 8; i < n; i++, p += 12)
+    {
+        if (!(sys = ubx_sys(U1(p))))
+            continue;
+        prn = U1(p + 1) + (sys == SYS_QZS ? 192 : 0);
+        if (!(sat = satno(sys, prn)))
+            continue;
+        rsol->azel[sat - 1][0] = I2(p + 4) * D2R;
+        rsol->azel[sat - 1][1] = (signed char)U1(p + 3) * D2R;
+        rsol->cno[sat - 1] = U1(p + 2);
+        rsol->vsat[sat - 1] = (U4(p + 8) & 0x08) ? 1 : 0; /* svUsed */
+    }
+    return 0;
+}
+#endif
+#if ENAUBX_TIMTP
+/* decode ubx-tim-tp: time pulse timedata ------------------------------------*/
+static int decode_timtp(raw_t *raw, const unsigned char *frm, int len)
+{
+    rcvsol_t *rsol = &raw->rsol;
+    const unsigned char *p = frm + 6;
+    double tow;
+    int week;
+
+    if (len < 24)
+    {
+        //        trace(2,"ubx timtp length error: len=%d\n",len);
+        return -1;
+    }
+    week = U2(p + 12);
+    tow = U4(p) * 1E-3 + U4(p + 4) * P2_32 * 1E-3;
+
+    /* gnss time base only (refinfo timeRefGnss 0:gps,2:bds) */
+    if (U1(p + 14) & 0x01)
+        return 0;
+
+    switch (U1(p + 15) & 0x0F)
+    {
+    case 0:
+        rsol->ttp = gpst2time(week, tow);
+        break;
+    case 2:
+        rsol->ttp = bdt2gpst(bdt2time(week, tow));
+        break;
+    default:
+        return 0; /* glonass/galileo time reference not supported */
+    }
+    rsol->qerr = I4(p + 8) * 1E-12;
+    return 6;
+}
+#endif
+#if ENAUBX_ACK
+/* acknowledge frame of ubx cfg transaction ----------------------------------*/
+static void ack_ubxcfg(ubxcfg_t *cfg, int type, int ack)
+{
+    const unsigned char *p;
+    int i;
+
+    /* receiver acknowledges cfg messages in order of input */
+    for (i = cfg->iack; i < cfg->isend; i++)
+    {
+        p = cfg->buff + cfg->off[i];
+        if (cfg->stat[i] != 1 || (U1(p + 2) << 8) + U1(p + 3) != type)
+            continue;
+        cfg->stat[i] = ack ? 2 : 3;
+        if (ack)
+            cfg->nack++;
+        else
+            cfg->nnak++;
+        break;
+    }
+    while (cfg->iack < cfg->isend && cfg->stat[cfg->iack] != 1)
+        cfg->iack++;
+}
+/* decode ubx-ack-ack/ack-nak: message acknowledged/not acknowledged ---------*/
+static int decode_ack(raw_t *raw, const unsigned char *frm, int len)
+{
+    if (len < 10)
+    {
+        //        trace(2,"ubx ack length error: len=%d\n",len);
+        return -1;
+    }
+    if (raw->ubxcfg)
+    {
+        ack_ubxcfg(raw->ubxcfg, (U1(frm + 6) << 8) + U1(frm + 7), U1(frm + 3) == 0x01);
+    }
+    return 0;
+}
+#endif
+/* ubx message decoders --------------------------------------------------------
+ * decoders are registered by message class/id. disable a decoder by defining
+ * ENAUBX_xxx to 0; messages without decoder are skipped before checksum.
+ *-----------------------------------------------------------------------------*/
+typedef struct
+{                        /* ubx message decoder type */
+    unsigned short type; /* message class/id */
+    int (*func)(raw_t *raw, const unsigned char *frm, int len);
+} ubxdec_t;
+
+static const ubxdec_t ubxdecs[] = {
+#if ENAUBX_RXMRAW
+    {ID_RXMRAW, decode_rxmraw},
+#endif
+#if ENAUBX_RXMRAWX
+    {ID_RXMRAWX, decode_rxmrawx},
+#endif
+#if ENAUBX_RXMSFRB
+    {ID_RXMSFRB, decode_rxmsfrb},
+#endif
+#if ENAUBX_RXMSFRBX
+    {ID_RXMSFRBX, decode_rxmsfrbx},
+#endif
+#if ENAUBX_NAVPVT
+    {ID_NAVPVT, decode_navpvt},
+#endif
+#if ENAUBX_NAVCLOCK
+    {ID_NAVCLOCK, decode_navclock},
+#endif
+#if ENAUBX_NAVSAT
+    {ID_NAVSAT, decode_navsat},
+#endif
+#if ENAUBX_TIMTP
+    {ID_TIMTP, decode_timtp},
+#endif
+#if ENAUBX_ACK
+    {ID_ACKACK, decode_ack},
+    {ID_ACKNAK, decode_ack},
+#endif
+    {0, NULL}};
+
+/* hash of ubx message class/id ----------------------------------------------*/
+static int hash_ubx(int type)
+{
+    return (type >> 8) * 7 + type;
+}
+/* search decoder of ubx message ---------------------------------------------*/
+static const ubxdec_t *getdec(raw_t *raw, int type)
+{
+    unsigned char *index = raw->ubxhash; /* decoder index + 1 (0: empty) */
+    int i, j;
+
+    /* build open-addressing hash index of decoder table at first call of receiver */
+    if (!raw->nubxhash)
+    {
+        for (i = 0; ubxdecs[i].func; i++)
+        {
+            for (j = hash_ubx(ubxdecs[i].type) & (NUBXHASH - 1); index[j];
+                 j = (j + 1) & (NUBXHASH - 1))
+                ;
+            index[j] = (unsigned char)(i + 1);
+        }
+        raw->nubxhash = i;
+    }
+    for (j = hash_ubx(type) & (NUBXHASH - 1); index[j]; j = (j + 1) & (NUBXHASH - 1))
+    {
+        if (ubxdecs[index[j] - 1].type == type)
+            return ubxdecs + index[j] - 1;
+    }
+    return NULL;
+}
+/* search or add statistics entry of ubx message (NULL: table full) ----------*/
+static ubxstat_t *getstat(raw_t *raw, int type)
+{
+    int i, j = hash_ubx(type) & (NUBXSTAT - 1);
+
+    if (!type)
+        return NULL;
+    for (i = 0; i < NUBXSTAT; i++, j = (j + 1) & (NUBXSTAT - 1))
+    {
+        if (raw->ubxstat[j].type == type)
+            return raw->ubxstat + j;
+        if (!raw->ubxstat[j].type)
+        {
+            raw->ubxstat[j].type = (unsigned short)type;
+            return raw->ubxstat + j;
+        }
+    }
+    return NULL;
+}
+/* decode ublox raw message --------------------------------------------------
+ * cs: checksum status (1:ok,0:error,-1:not tested)
+ * notes: messages without decoder are checksum tested only to be counted in
+ *        raw->ubxstat. no string is formatted unless raw->outtype is set.
+ *---------------------------------------------------------------------------*/
+static int decode_ubx(raw_t *raw, const unsigned char *frm, int len, int cs)
+{
+    const ubxdec_t *dec;
+    ubxstat_t *st;
+    unsigned int tick;
+    int type, stat;
+
+    /* frame shorter than header and checksum */
+    if (len < 8)
+        return -1;
+    type = (U1(frm + 2) << 8) + U1(frm + 3);
+    dec = getdec(raw, type);
+
+    //   printf("decode_ubx: type=%04x len=%d\n",type,len);
 
     /* checksum */
-    if (!checksum(raw->buff, raw->len))
+    if (cs < 0 ? !checksum(frm, len) : !cs)
     {
-        //        printf("ubx checksum error: type=%04x len=%d\n",type,raw->len);
+        //        printf("ubx checksum error: type=%04x len=%d\n",type,len);
+        if (!dec)
+            return 0;
+        if ((st = getstat(raw, type)) != NULL)
+            st->ncs++;
         return -1;
     }
+    if ((st = getstat(raw, type)) != NULL)
+    {
+        st->n++;
+        st->bytes += len;
+    }
+    if (!dec)
+        return 0;
+
     if (raw->outtype)
     {
-        sprintf(raw->msgtype, "UBX 0x%04X (%4d):", type, raw->len);
+        sprintf(raw->msgtype, "UBX 0x%04X (%4d):", type, len);
+    }
+    tick = UBXTICK();
+    stat = dec->func(raw, frm, len);
+    if (st)
+        st->tdec += UBXTICK() - tick;
+
+    /* signal decoded data to processing loop */
+    switch (stat)
+    {
+    case 1:
+        push_rawevt(raw, EVT_OBS, 0);
+        break;
+    case 2:
+        push_rawevt(raw, EVT_EPH, raw->ephsat);
+        break;
+    case 3:
+        push_rawevt(raw, EVT_SBAS, raw->sbsmsg.prn);
+        break;
+    case 9:
+        push_rawevt(raw, EVT_IONUTC, 0);
+        break;
     }
-    switch (type)
+    return stat;
+}
+/* test running checksum of message buffer -----------------------------------*/
+static int testcs(const raw_t *raw)
+{
+    return raw->cka == raw->buff[raw->len - 2] && raw->ckb == raw->buff[raw->len - 1];
+}
+/* copy stream data to message buffer with running checksum ------------------*/
+static void copy_ubx(raw_t *raw, const unsigned char *p, int n)
+{
+    unsigned char *q = raw->buff + raw->nbyte, cka = raw->cka, ckb = raw->ckb;
+    int i, m = (raw->nbyte < 6 ? 6 : raw->len - 2) - raw->nbyte;
+
+    for (i = 0; i < n; i++)
     {
-    case ID_RXMRAW:
-        return decode_rxmraw(raw);
-    case ID_RXMRAWX:
-        return decode_rxmrawx(raw);
-    case ID_RXMSFRB:
-        return decode_rxmsfrb(raw);
-    case ID_RXMSFRBX:
-        return decode_rxmsfrbx(raw);
+        q[i] = p[i];
+        if (i < m)
+        {
+            cka += p[i];
+            ckb += cka;
+        }
     }
-    return 0;
+    raw->cka = cka;
+    raw->ckb = ckb;
+    raw->nbyte += n;
 }
 /* sync code -----------------------------------------------------------------*/
 static int sync_ubx(unsigned char *buff, unsigned char data)
@@ -804,6 +1379,8 @@ static int sync_ubx(unsigned char *buff, unsigned char data)
  *          unsigned char data I stream data (1 byte)
  * return : status (-1: error message, 0: no message, 1: input observation data,
  *                  2: input ephemeris, 3: input sbas message,
+ *                  5: input receiver position (nav-pvt),
+ *                  6: input receiver time (nav-clock,tim-tp),
  *                  9: input ion/utc parameter)
  *
  * notes  : to specify input options, set raw->opt to the following option
@@ -824,8 +1401,15 @@ extern int input_ubx(raw_t *raw, unsigned char data)
         if (!sync_ubx(raw->buff, data))
             return 0;
         raw->nbyte = 2;
+        raw->cka = raw->ckb = 0;
         return 0;
     }
+    /* running checksum (class to end of payload) */
+    if (raw->nbyte < 6 || raw->nbyte < raw->len - 2)
+    {
+        raw->cka += data;
+        raw->ckb += raw->cka;
+    }
     raw->buff[raw->nbyte++] = data;
 
     if (raw->nbyte == 6)
@@ -842,7 +1426,125 @@ extern int input_ubx(raw_t *raw, unsigned char data)
     raw->nbyte = 0;
 
     /* decode ublox raw message */
-    return decode_ubx(raw);
+    return decode_ubx(raw, raw->buff, raw->len, testcs(raw));
+}
+/* input ublox raw messages from stream block ----------------------------------
+ * fetch ublox raw messages from a block of stream data and decode all complete
+ * frames in it
+ * args   : raw_t *raw   IO     receiver raw data control struct
+ *          unsigned char *buff I stream data
+ *          int    n     I      length of stream data (bytes)
+ *          rawfunc_t func I    callback for each decoded message (NULL: none)
+ *                              func(raw,stat) is called for every message with
+ *                              non-zero status (see input_ubx())
+ * return : number of messages with non-zero status in the block
+ * notes  : partial frames are kept in raw->buff and completed by the next call,
+ *          so input_ubx() and input_ubx_block() can be mixed on one stream.
+ *          sync code is searched by memchr(). frames complete in the block are
+ *          decoded in place without copy. only a frame split over the block
+ *          end is copied to raw->buff, so a ring buffer is input as its two
+ *          contiguous segments and a frame wrapping the ring end is assembled.
+ *-----------------------------------------------------------------------------*/
+extern int input_ubx_block(raw_t *raw, const unsigned char *buff, int n,
+                           rawfunc_t func)
+{
+    const unsigned char *p = buff, *q, *end = buff + n;
+    int len, stat, nmsg = 0;
+
+    while (p < end)
+    {
+        /* synchronize frame */
+        if (raw->nbyte == 0)
+        {
+            if (raw->buff[1] == UBXSYNC1 && *p == UBXSYNC2)
+            {
+                raw->buff[0] = UBXSYNC1;
+                raw->buff[1] = *p++;
+                raw->nbyte = 2;
+                raw->cka = raw->ckb = 0;
+                continue;
+            }
+            if (!(q = (const unsigned char *)memchr(p, UBXSYNC1, end - p)))
+            {
+                raw->buff[1] = end[-1];
+                break;
+            }
+            /* decode complete frame in place */
+            if (end - q >= 6 && q[1] == UBXSYNC2)
+            {
+                raw->buff[1] = UBXSYNC2;
+                if ((len = U2(q + 4) + 8) > MAXRAWLEN)
+                {
+                    p = q + 6;
+                    nmsg++;
+                    if (func)
+                        func(raw, -1);
+                    continue;
+                }
+                if (end - q >= len)
+                {
+                    raw->len = len;
+                    p = q + len;
+                    if ((stat = decode_ubx(raw, q, len, -1)) != 0)
+                    {
+                        nmsg++;
+                        if (func)
+                            func(raw, stat);
+                    }
+                    continue;
+                }
+            }
+            raw->buff[1] = *q;
+            p = q + 1;
+            continue;
+        }
+        /* frame header */
+        if (raw->nbyte < 6)
+        {
+            len = 6 - raw->nbyte < end - p ? 6 - raw->nbyte : (int)(end - p);
+            copy_ubx(raw, p, len);
+            p += len;
+            if (raw->nbyte < 6)
+                break;
+
+            if ((raw->len = U2(raw->buff + 4) + 8) > MAXRAWLEN)
+            {
+                raw->nbyte = 0;
+                nmsg++;
+                if (func)
+                    func(raw, -1);
+                continue;
+            }
+        }
+        /* frame body */
+        len = raw->len - raw->nbyte < end - p ? raw->len - raw->nbyte : (int)(end - p);
+        copy_ubx(raw, p, len);
+        p += len;
+        if (raw->nbyte < raw->len)
+            break;
+        raw->nbyte = 0;
+
+        /* decode ublox raw message */
+        if ((stat = decode_ubx(raw, raw->buff, raw->len, testcs(raw))) != 0)
+        {
+            nmsg++;
+            if (func)
+                func(raw, stat);
+        }
+    }
+    return nmsg;
+}
+/* input ublox frame -----------------------------------------------------------
+ * decode a complete ublox frame already validated by the caller (demux)
+ * args   : raw_t *raw   IO     receiver raw data control struct
+ *          unsigned char *frm I ublox frame (sync code to checksum)
+ *          int    len   I      frame length (bytes)
+ * return : status (-1...9: same as input_ubx())
+ *-----------------------------------------------------------------------------*/
+extern int input_ubxfrm(raw_t *raw, const unsigned char *frm, int len)
+{
+    raw->len = len;
+    return decode_ubx(raw, frm, len, 1);
 }
 /* input ublox raw message from file -------------------------------------------
  * fetch next ublox raw data and input a message from file
@@ -884,14 +1586,48 @@ extern int input_ubxf(raw_t *raw, FILE *fp)
     raw->nbyte = 0;
 
     /* decode ubx raw message */
-    return decode_ubx(raw);
+    return decode_ubx(raw, raw->buff, raw->len, -1);
+}
+/* output ublox message statistics ---------------------------------------------
+ * output per message type counters of raw->ubxstat as text lines sorted by
+ * class/id:
+ *   UBX 0xccii n=count bytes=bytes cserr=errors tdec=ticks (ticks/msg)
+ * args   : unsigned char *buff O output buffer (MAXSOLMSG bytes)
+ *          raw_t *raw   I      receiver raw data control struct
+ * return : number of output bytes
+ * notes  : tdec is counted by UBXTICK() (cpu cycles on target). counters wrap
+ *          around at 2^32.
+ *-----------------------------------------------------------------------------*/
+extern int outubxstat(unsigned char *buff, const raw_t *raw)
+{
+    const ubxstat_t *st;
+    char *p = (char *)buff;
+    int i, j, k, index[NUBXSTAT], n = 0;
+
+    for (i = 0; i < NUBXSTAT; i++)
+    {
+        if (!raw->ubxstat[i].type)
+            continue;
+        for (j = n++; j > 0 && raw->ubxstat[index[j - 1]].type > raw->ubxstat[i].type; j--)
+            index[j] = index[j - 1];
+        index[j] = i;
+    }
+    for (k = 0; k < n; k++)
+    {
+        st = raw->ubxstat + index[k];
+        p += sprintf(p, "UBX 0x%04X n=%u bytes=%u cserr=%u tdec=%u (%.0f)\r\n",
+                     st->type, st->n, st->bytes, st->ncs, st->tdec,
+                     st->n ? (double)st->tdec / st->n : 0.0);
+    }
+    *p = '\0';
+    return p - (char *)buff;
 }
 /* generate ublox binary message -----------------------------------------------
  * generate ublox binary message from message string
  * args   : char  *msg   IO     message string
  *            "CFG-PRT   portid res0 res1 mode baudrate inmask outmask flags"
  *            "CFG-USB   vendid prodid res1 res2 power flags vstr pstr serino"
- *            "CFG-MSG   msgid rate0 rate1 rate2 rate3"
+ *            "CFG-MSG   msgclass msgid rate0 rate1 rate2 rate3 rate4 rate5"
  *            "CFG-NMEA  filter version numsv flags"
  *            "CFG-RATE  meas nav time"
  *            "CFG-CFG   clear_mask save_mask load_mask"
@@ -909,22 +1645,31 @@ extern int input_ubxf(raw_t *raw, FILE *fp)
  *            "CFG-TM2   ch res0 res1 rate flags"
  *            "CFG-TMODE tmode posx posy posz posvar svinmindur svinvarlimit"
  *            "CFG-EKF   ..."
+ *            "CFG-GNSS  msgver numtrkchhw numtrkchuse numblocks
+ *                       [gnssid restrkch maxtrkch res flags] ..."
  *          unsigned char *buff O binary message
  * return : length of binary message (0: error)
  * note   : see reference [1] for details.
+ *          the last block of fields of CFG-GNSS is repeated while arguments
+ *          remain. cfg blobs for the firmware are generated from these
+ *          strings at build time by APP/ubxcfg.
  *-----------------------------------------------------------------------------*/
 extern int gen_ubx(const char *msg, unsigned char *buff)
 {
     const char *cmd[] = {
         "PRT", "USB", "MSG", "NMEA", "RATE", "CFG", "TP", "NAV2", "DAT", "INF",
-        "RST", "RXM", "ANT", "FXN", "SBAS", "LIC", "TM", "TM2", "TMODE", "EKF", ""};
+        "RST", "RXM", "ANT", "FXN", "SBAS", "LIC", "TM", "TM2", "TMODE", "EKF",
+        "GNSS", ""};
     const unsigned char id[] = {
         0x00, 0x1B, 0x01, 0x17, 0x08, 0x09, 0x07, 0x1A, 0x06, 0x02,
-        0x04, 0x11, 0x13, 0x0E, 0x16, 0x80, 0x10, 0x19, 0x1D, 0x12};
+        0x04, 0x11, 0x13, 0x0E, 0x16, 0x80, 0x10, 0x19, 0x1D, 0x12,
+        0x3E};
+    const int nrep[] = { /* number of repeated last fields */
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 5};
     const int prm[][32] = {
         {FU1, FU1, FU2, FU4, FU4, FU2, FU2, FU2, FU2},    /* PRT */
         {FU2, FU2, FU2, FU2, FU2, FU2, FS32, FS32, FS32}, /* USB */
-        {FU1, FU1, FU1, FU1, FU1, FU1},                   /* MSG */
+        {FU1, FU1, FU1, FU1, FU1, FU1, FU1, FU1},         /* MSG */
         {FU1, FU1, FU1, FU1},                             /* NMEA */
         {FU2, FU2, FU2},                                  /* RATE */
         {FU4, FU4, FU4},                                  /* CFG */
@@ -942,16 +1687,17 @@ extern int gen_ubx(const char *msg, unsigned char *buff)
         {FU4, FU4, FU4},                                   /* TM */
         {FU1, FU1, FU2, FU4, FU4},                         /* TM2 */
         {FU4, FI4, FI4, FI4, FU4, FU4, FU4},               /* TMODE */
-        {FU1, FU1, FU1, FU1, FU4, FU2, FU2, FU1, FU1, FU2} /* EKF */
+        {FU1, FU1, FU1, FU1, FU4, FU2, FU2, FU1, FU1, FU2}, /* EKF */
+        {FU1, FU1, FU1, FU1, FU1, FU1, FU1, FU1, FU4}       /* GNSS */
     };
     unsigned char *q = buff;
-    char mbuff[1024], *args[32], *p;
-    int i, j, n, narg = 0;
+    char mbuff[1024], *args[64], *p;
+    int i, j, k, n, narg = 0;
 
     //    printf("gen_ubxf: msg=%s\n",msg);
 
     strcpy(mbuff, msg);
-    for (p = strtok(mbuff, " "); p && narg < 32; p = strtok(NULL, " "))
+    for (p = strtok(mbuff, " "); p && narg < 64; p = strtok(NULL, " "))
     {
         args[narg++] = p;
     }
@@ -971,9 +1717,9 @@ extern int gen_ubx(const char *msg, unsigned char *buff)
     *q++ = UBXCFG;
     *q++ = id[i];
     q += 2;
-    for (j = 1; prm[i][j - 1] > 0; j++)
+    for (j = 1, k = 0; prm[i][k] > 0; j++)
     {
-        switch (prm[i][j - 1])
+        switch (prm[i][k++])
         {
         case FU1:
             setU1(q, j < narg ? (unsigned char)atoi(args[j]) : 0);
@@ -1012,6 +1758,8 @@ extern int gen_ubx(const char *msg, unsigned char *buff)
             q += 32;
             break;
         }
+        if (prm[i][k] <= 0 && nrep[i] > 0 && j + 1 < narg)
+            k -= nrep[i];
     }
     n = (int)(q - buff) + 2;
     setU2(buff + 4, (unsigned short)(n - 8));
@@ -1021,3 +1769,91 @@ extern int gen_ubx(const char *msg, unsigned char *buff)
     //		traceb(5,buff,n);
     return n;
 }
+/* initialize ubx cfg transaction ----------------------------------------------
+ * initialize pipelined transaction of ubx cfg messages
+ * args   : ubxcfg_t *cfg O     ubx cfg transaction
+ *          unsigned char *buff I cfg blob (concatenated ubx frames, generated
+ *                              by APP/ubxcfg from a receiver profile)
+ *          int    n     I      length of cfg blob (bytes)
+ *          int    window I     max frames waiting ack (0: no limit)
+ *          unsigned int tout I ack timeout (ticks of send_ubxcfg())
+ * return : number of frames (0: error)
+ * notes  : set raw->ubxcfg to the transaction to route ack-ack/ack-nak
+ *          messages of the receiver to it.
+ *-----------------------------------------------------------------------------*/
+extern int init_ubxcfg(ubxcfg_t *cfg, const unsigned char *buff, int n,
+                       int window, unsigned int tout)
+{
+    int i, len;
+
+    memset(cfg, 0, sizeof(ubxcfg_t));
+    cfg->buff = buff;
+    cfg->window = window;
+    cfg->tout = tout;
+
+    for (i = 0; i < n; i += len)
+    {
+        if (cfg->nfrm >= MAXUBXCFG || n - i < 8 || buff[i] != UBXSYNC1 ||
+            buff[i + 1] != UBXSYNC2 || (len = U2(buff + i + 4) + 8) > n - i)
+        {
+            //            trace(2,"ubx cfg blob error: offset=%d\n",i);
+            cfg->nfrm = 0;
+            return 0;
+        }
+        cfg->off[cfg->nfrm++] = (unsigned short)i;
+    }
+    cfg->off[cfg->nfrm] = (unsigned short)n;
+    return cfg->nfrm;
+}
+/* send ubx cfg transaction ----------------------------------------------------
+ * send frames of ubx cfg transaction without blocking. frames are streamed
+ * back-to-back up to the window of frames waiting ack, so the configuration is
+ * sent as one burst instead of a round trip per message.
+ * args   : ubxcfg_t *cfg IO    ubx cfg transaction
+ *          ubxwrite_t write I  non-blocking write function
+ *                              write(buff,n) returns number of bytes written
+ *          unsigned int tick I current time (ticks, wrap around allowed)
+ * return : status (1: all acknowledged, 0: in progress,
+ *                  -1: completed with nak or timeout)
+ * notes  : call periodically with input of receiver messages to the raw_t
+ *          whose raw->ubxcfg is cfg. frames waiting ack longer than cfg->tout
+ *          are counted as timeout and leave the window.
+ *-----------------------------------------------------------------------------*/
+extern int send_ubxcfg(ubxcfg_t *cfg, ubxwrite_t write, unsigned int tick)
+{
+    const unsigned char *p;
+    int i, len, n;
+
+    /* ack timeout */
+    for (i = cfg->iack; i < cfg->isend; i++)
+    {
+        if (cfg->stat[i] == 1 && tick - cfg->tsent[i] > cfg->tout)
+        {
+            cfg->stat[i] = 4;
+            cfg->ntout++;
+        }
+    }
+    while (cfg->iack < cfg->isend && cfg->stat[cfg->iack] != 1)
+        cfg->iack++;
+
+    /* stream frames within window */
+    while (cfg->isend < cfg->nfrm &&
+           (cfg->window <= 0 || cfg->isend - cfg->iack < cfg->window))
+    {
+        p = cfg->buff + cfg->off[cfg->isend];
+        len = cfg->off[cfg->isend + 1] - cfg->off[cfg->isend];
+        if ((n = write(p + cfg->nbyte, len - cfg->nbyte)) <= 0)
+            break;
+        if ((cfg->nbyte += n) < len)
+            break;
+        cfg->nbyte = 0;
+        cfg->tsent[cfg->isend] = tick;
+        cfg->stat[cfg->isend++] = U1(p + 2) == UBXCFG ? 1 : 2; /* no ack for non-cfg */
+    }
+    while (cfg->iack < cfg->isend && cfg->stat[cfg->iack] != 1)
+        cfg->iack++;
+
+    if (cfg->iack < cfg->nfrm)
+        return 0;
+    return cfg->nnak || cfg->ntout ? -1 : 1;
+}
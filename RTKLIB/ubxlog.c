@@ -0,0 +1,204 @@
+/*------------------------------------------------------------------------------
+ * ubxlog.c : time-indexed ublox raw capture log
+ *
+ * description : write receiver frames to a capture file with a sidecar index
+ *               file (file.idx) and seek the capture to a time by the index.
+ *               the capture file is the plain frame stream, so it is input by
+ *               input_ubxf()/input_rawf() as before.
+ *
+ *               the capture is divided into fixed blocks (blksize bytes). the
+ *               first epoch frame (rxm-rawx, rxm-raw) starting in each block
+ *               is indexed with its gpst, byte offset and message type. a seek
+ *               is a binary search of the index and a scan of one block at most.
+ *
+ *               index file format (little-endian):
+ *                 header (16 bytes) : "UBXIDX1\0", blksize (u4), reserved (u4)
+ *                 record (16 bytes) : time (u4, gpst seconds of gtime_t),
+ *                                     msec (u2), type (u2, class/id),
+ *                                     offset (u4), length (u4)
+ *
+ * history : 2026/10/17 1.0 new
+ *-----------------------------------------------------------------------------*/
+#include "rtklib.h"
+
+#define UBXLOGID "UBXIDX1" /* index file id */
+#define ID_RXMRAW 0x0210   /* ubx message id: raw measurement data */
+#define ID_RXMRAWX 0x0215  /* ubx message id: multi-gnss raw meas data */
+
+/* get/set fields (little-endian) --------------------------------------------*/
+static unsigned int getu(const unsigned char *p, int n)
+{
+    unsigned int u = 0;
+
+    while (n--)
+        u = (u << 8) | p[n];
+    return u;
+}
+static void setu(unsigned char *p, int n, unsigned int u)
+{
+    int i;
+
+    for (i = 0; i < n; i++, u >>= 8)
+        p[i] = (unsigned char)u;
+}
+/* time of epoch frame (0: not epoch frame) ----------------------------------*/
+static int frametime(const unsigned char *frm, int len, gtime_t *time)
+{
+    double tow;
+
+    switch (getu(frm + 2, 1) << 8 | getu(frm + 3, 1))
+    {
+    case ID_RXMRAWX:
+        if (len < 24)
+            return 0;
+        memcpy(&tow, frm + 6, 8);
+        *time = gpst2time((int)getu(frm + 14, 2), tow);
+        return 1;
+    case ID_RXMRAW:
+        if (len < 16)
+            return 0;
+        *time = gpst2time((int)getu(frm + 10, 2), (int)getu(frm + 6, 4) * 1E-3);
+        return 1;
+    }
+    return 0;
+}
+/* open capture log ------------------------------------------------------------
+ * args   : ubxlog_t *log O     capture log
+ *          char   *file  I     capture file path (index file: file.idx)
+ *          int    mode   I     open mode (0:read,1:write)
+ *          int    blksize I    block size (bytes) (write, 0: UBXLOGBLK)
+ * return : status (1:ok,0:error)
+ * notes  : the reader loads the whole index to memory.
+ *-----------------------------------------------------------------------------*/
+extern int open_ubxlog(ubxlog_t *log, const char *file, int mode, int blksize)
+{
+    unsigned char buff[16];
+    char path[1024];
+    FILE *fp;
+    int i, n;
+
+    memset(log, 0, sizeof(ubxlog_t));
+    sprintf(path, "%.1019s.idx", file);
+    log->mode = mode;
+
+    if (mode)
+    {
+        log->blksize = blksize > 0 ? blksize : UBXLOGBLK;
+        if (!(log->fp = fopen(file, "wb")))
+            return 0;
+        if (!(log->fpi = fopen(path, "wb")))
+        {
+            fclose(log->fp);
+            return 0;
+        }
+        memset(buff, 0, 16);
+        memcpy(buff, UBXLOGID, 7);
+        setu(buff + 8, 4, (unsigned int)log->blksize);
+        fwrite(buff, 1, 16, log->fpi);
+        return 1;
+    }
+    if (!(log->fp = fopen(file, "rb")))
+        return 0;
+    if (!(fp = fopen(path, "rb")))
+        return 1; /* no index: read from start */
+
+    if (fread(buff, 1, 16, fp) == 16 && !memcmp(buff, UBXLOGID, 7))
+    {
+        log->blksize = (int)getu(buff + 8, 4);
+        fseek(fp, 0, SEEK_END);
+        n = (int)(ftell(fp) / 16) - 1;
+        fseek(fp, 16, SEEK_SET);
+        if (n > 0 && (log->index = (ubxidx_t *)malloc(sizeof(ubxidx_t) * n)))
+        {
+            for (i = 0; i < n && fread(buff, 1, 16, fp) == 16; i++)
+            {
+                log->index[i].time.time = (time_t)getu(buff, 4);
+                log->index[i].time.sec = getu(buff + 4, 2) * 1E-3;
+                log->index[i].type = (unsigned short)getu(buff + 6, 2);
+                log->index[i].offset = getu(buff + 8, 4);
+                log->index[i].len = getu(buff + 12, 4);
+            }
+            log->n = i;
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+/* close capture log -----------------------------------------------------------
+ * args   : ubxlog_t *log IO    capture log
+ * return : none
+ *-----------------------------------------------------------------------------*/
+extern void close_ubxlog(ubxlog_t *log)
+{
+    if (log->fp)
+        fclose(log->fp);
+    if (log->fpi)
+        fclose(log->fpi);
+    free(log->index);
+    log->fp = log->fpi = NULL;
+    log->index = NULL;
+    log->n = 0;
+}
+/* write frame to capture log --------------------------------------------------
+ * args   : ubxlog_t *log IO    capture log (write)
+ *          unsigned char *frm I frame (ubx, nmea or rtcm 3)
+ *          int    len    I     frame length (bytes)
+ * return : status (1:ok,0:error)
+ * notes  : set as dmx->func to capture all valid frames of a stream. the
+ *          first epoch frame starting in each block is indexed.
+ *-----------------------------------------------------------------------------*/
+extern int write_ubxlog(ubxlog_t *log, const unsigned char *frm, int len)
+{
+    unsigned char buff[16];
+    gtime_t time;
+
+    if (!log->fp || !log->mode)
+        return 0;
+
+    if (log->offset >= log->blkend && len >= 8 && frm[0] == 0xB5 &&
+        frm[1] == 0x62 && frametime(frm, len, &time))
+    {
+        setu(buff, 4, (unsigned int)time.time);
+        setu(buff + 4, 2, (unsigned int)(time.sec * 1E3 + 0.5));
+        setu(buff + 6, 2, getu(frm + 2, 1) << 8 | getu(frm + 3, 1));
+        setu(buff + 8, 4, log->offset);
+        setu(buff + 12, 4, (unsigned int)len);
+        if (fwrite(buff, 1, 16, log->fpi) < 16)
+            return 0;
+        log->blkend = (log->offset / log->blksize + 1) * log->blksize;
+    }
+    if (fwrite(frm, 1, len, log->fp) < (size_t)len)
+        return 0;
+    log->offset += len;
+    return 1;
+}
+/* seek capture log to time ----------------------------------------------------
+ * seek capture file to the indexed epoch frame before time, so the frames of
+ * epochs at or after time are input by the following input_ubxf(raw,log->fp)
+ * args   : ubxlog_t *log IO    capture log (read)
+ *          gtime_t time  I     time (gpst)
+ * return : byte offset of the capture file
+ * notes  : without index the capture file is rewound to start. frames before
+ *          time (up to one block) are input and should be skipped by time.
+ *-----------------------------------------------------------------------------*/
+extern unsigned int seek_ubxlog(ubxlog_t *log, gtime_t time)
+{
+    unsigned int offset = 0;
+    int i = 0, j = log->n - 1, k;
+
+    /* last record with time before the time */
+    while (i <= j)
+    {
+        k = (i + j) / 2;
+        if (timediff(log->index[k].time, time) < 0.0)
+        {
+            offset = log->index[k].offset;
+            i = k + 1;
+        }
+        else
+            j = k - 1;
+    }
+    if (log->fp)
+        fseek(log->fp, (long)offset, SEEK_SET);
+    return offset;
+}
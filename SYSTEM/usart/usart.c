@@ -1,5 +1,6 @@
 #include "sys.h"
 #include "usart.h"	  
+#include "rtklib.h"
 ////////////////////////////////////////////////////////////////////////////////// 	 
 //ʹucos,ͷļ.
 #if SYSTEM_SUPPORT_OS
@@ -30,13 +31,28 @@ void _sys_exit(int x)
 { 
 	x = x; 
 } 
-//ضfputc 
+//ͼ¼:printfд,solve()дԪ¼,жֽڷ
+//ѭٵȴڷ,ʱɵδͼ¼(=nrec-nsent-)
+outq_t USART1_TX_Q;
+static u8 USART1_TX_LINE[256];		//printfл
+static u16 USART1_TX_LEN=0;
+//ضfputc:дл,нд뷢ͼ¼,ȴ
 int fputc(int ch, FILE *f)
 {      
-	while((USART1->ISR&0X40)==0);//ѭ,ֱ   
-	USART1->TDR = (u8) ch;      
+	USART1_TX_LINE[USART1_TX_LEN++]=(u8)ch;
+	if(ch=='\n'||USART1_TX_LEN>=sizeof(USART1_TX_LINE))
+	{
+		write_outq(&USART1_TX_Q,USART1_TX_LINE,USART1_TX_LEN);
+		USART1_TX_LEN=0;
+		usart1_txstart();
+	}
 	return ch;
 }
+//:ʹܷݼĴж(TXEIE),жϷͶеļ¼
+void usart1_txstart(void)
+{
+	USART1->CR1|=1<<7;
+}
 #endif 
 //end
 //////////////////////////////////////////////////////////////////
@@ -50,10 +66,22 @@ u8 USART_RX_BUF[USART_REC_LEN];     //
 //bit14	յ0x0d
 //bit13~0	յЧֽĿ
 u16 USART_RX_STA=0;       //״̬	  
+#endif
   
 void USART1_IRQHandler(void)
 {
+	const unsigned char *p;
 	u8 res;	
+	if((USART1->CR1&(1<<7))&&(USART1->ISR&(1<<7)))//ݼĴ
+	{
+		if(peek_outq(&USART1_TX_Q,&p)>0)
+		{
+			USART1->TDR=*p;
+			skip_outq(&USART1_TX_Q,1);
+		}
+		else USART1->CR1&=~(1<<7);	//п,رշж(usart1_txstartʹ)
+	}
+#if EN_USART1_RX
 	if(USART1->ISR&(1<<5))//յ
 	{	 
 		res=USART1->RDR; 
@@ -75,8 +103,8 @@ void USART1_IRQHandler(void)
 			}
 		}  		 									     
 	} 
+#endif
 } 
-#endif										 
 //ʼIO 1
 //pclk2:PCLK2ʱƵ(Mhz)
 //bound: 
@@ -100,8 +128,9 @@ void uart_init(u32 pclk2,u32 bound)
 	//ʹܽж 
 	USART1->CR1|=1<<2;  	//ڽʹ
 	USART1->CR1|=1<<5;    	//ջǿжʹ	    	
-	MY_NVIC_Init(3,3,USART1_IRQn,2);//2ȼ 
 #endif
+	init_outq(&USART1_TX_Q);	//ʼͼ¼(ʹжǰ)
+	MY_NVIC_Init(3,3,USART1_IRQn,2);//2ȼ 
 	USART1->CR1|=1<<0;  	//ʹ
 }
 
@@ -15,11 +15,11 @@
   Support     	 : QQ:459757196
 ******************************************************************/
 
-unsigned char Soluion_GGA[150];
-unsigned char Soluion_RMC[150];
-unsigned char Soluion_GSV[150];
-unsigned char Soluion_GSA[150];
 strsvr_t svr;
+demux_t dmx;
+ubxcfg_t ubxcfg;
+extern const unsigned char ubxprofile[]; // ջ(APP/ubxcfg)
+extern const int ubxprofile_len;
 
 const prcopt_t default_opt = {
     /* defaults processing options */
@@ -61,83 +61,115 @@ const prcopt_t default_opt = {
     30.0, /* maxtdif,maxinno,maxgdop */
     {0},
     {0},
-    {10.780175707, 106.660899381, 31.5523} /* baseline,ru,rb */
+    {10.780175707, 106.660899381, 31.5523}, /* baseline,ru,rb */
+    {0, 0, 0, 0, 1, 0}                      /* posopt (raim fde) */
     //    {"",""},                    /* anttype */
     //    {{0}},{{0}},{0}             /* antdel,pcv,exsats */
 };
 
-int main(void)
+/* 㶨λ㲢 (RXM-RAWXʱ)
+ * Ԫʽ1ͼ¼, ɷжϷ, 㲻ȴ
+ * LAT: ->,->,->,һ¼д->,ֵ (ms) */
+static void solve(const rawevt_t *evt)
 {
+    static u8 led = 0;
     double ep[6];
-    u16 t;
-    u16 len;
-    u8 led = 0;
     gtime_t time;
+    unsigned char *rec, *p;
+    unsigned int tsol;
+
+    if (led)
+        LED0(0);
+    else
+        LED0(1);
+    led = ~led;
+
+    time = gpst2utc(svr.raw[0].time);//GPSTתΪUTCʱ䣬
+    if (time.sec >= 0.995)
+    {
+        time.time++;
+        time.sec = 0.0;
+    }
+    time2epoch(time, ep);//1970.1.1ת
+
+    rtkpos(&svr.rtk, svr.raw[0].obs.data, svr.raw[0].obs.n, &svr.raw[0].nav);
+    tsol = tickcnt();
+    svr.rtk.sol.processTime = (int)((tsol - evt->tarr) / TICKFREQ * 1E6);
+    //				outsol(Soluion,&svr.rtk.sol,svr.rtk.rb);
+    //				printf("GPGGA,%s\r\n",Soluion);
+    rec = p = alloc_outq(&USART1_TX_Q); // Ͷʱɵδͼ¼
+    p += outnmea_gga(p, &svr.rtk.sol);
+    p += outnmea_rmc(p, &svr.rtk.sol, &svr.dirp);
+    p += outnmea_gsa(p, &svr.rtk.sol, svr.rtk.ssat);
+    p += outnmea_gsv(p, &svr.rtk.sol, svr.rtk.ssat);
+    p += sprintf((char *)p, "\r\nERROR,%.255s\r\n", svr.rtk.errbuf);
+    p += sprintf((char *)p, "RXBUF,%u,%u,%u,%u\r\n", USART3_RX_RING.hwm, USART3_RX_RING.novf, USART3_RX_RING.nlost, USART3_ORE_CNT); // ջ:ˮλ,,ֽ,Ӳ
+    p += sprintf((char *)p, "TXQ,%u,%u\r\n", USART1_TX_Q.nrec, USART1_TX_Q.nsent);                                                        // Ͷ:д¼,ѷͼ¼
+    p += sprintf((char *)p, "LAT,%.3f,%.3f,%.3f,%.3f,%.3f\r\n", (evt->tdec - evt->tarr) / TICKFREQ * 1E3, (tsol - evt->tdec) / TICKFREQ * 1E3,
+                 (tsol - evt->tarr) / TICKFREQ * 1E3, USART1_TX_Q.tout / TICKFREQ * 1E3, USART1_TX_Q.toutmax / TICKFREQ * 1E3); // ӳ(ms)
+
+    //				printf("SATNUM=%02d,%02.0f%02.0f%05.2f,\r\n",svr.raw[0].obs.n,svr.raw[0].time.time,svr.raw[0].time.sec);
+    p += sprintf((char *)p, "SATNUM=%02d,%02.0f%02.0f%05.2f,%02.0f%02.0f%02d*FF\r\n", svr.raw[0].obs.n, ep[3], ep[4], ep[5], ep[2], ep[1], (int)ep[0] % 100);
+    commit_outq(&USART1_TX_Q, p - rec);
+    usart1_txstart();
+    //				for(t=0;t<svr.raw[0].obs.n;t++)
+    //				{
+    //					printf("GPSSYS=%d*EE\r\n",svr.raw[0].obs.data[t].rcv);
+    //					if(svr.raw[0].obs.data[t].sat<33)
+    //					printf("GPSSYS=G%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
+    //					else if(svr.raw[0].obs.data[t].sat>=33&&svr.raw[0].obs.data[t].sat<57)
+    //					printf("GLOSYS=R%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-32,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
+    //					else if(svr.raw[0].obs.data[t].sat>=57&&svr.raw[0].obs.data[t].sat<84)
+    //					printf("GALSYS=E%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-56,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
+    //					else if(svr.raw[0].obs.data[t].sat>=84&&svr.raw[0].obs.data[t].sat<87)
+    //					printf("QZSSYS=J%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-83,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
+    //					else if(svr.raw[0].obs.data[t].sat>=87&&svr.raw[0].obs.data[t].sat<122)
+    //					printf("BDSSYS=C%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-86,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
+    //					else if(svr.raw[0].obs.data[t].sat>=122&&svr.raw[0].obs.data[t].sat<144)
+    //					printf("SBASYS=%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-2,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
+    //						printf("week sec:%.3lf,%.8lf\r\n",svr.raw[0].nav.eph[svr.raw[0].obs.data[t].sat-1].A,svr.raw[0].nav.eph[svr.raw[0].obs.data[t].sat-1].e);
+    //				}
+}
+/* ubxص: ÿ֡ȡ¼, ÿ۲Ԫ(RXM-RAWX)Ｔ */
+static void rawfunc(raw_t *raw, int stat)
+{
+    rawevt_t evt;
+
+    while (get_rawevt(raw, &evt))
+    {
+        if (evt.type == EVT_OBS)
+            solve(&evt);
+    }
+}
+int main(void)
+{
+    static unsigned char buff[USART3_MAX_RECV_LEN];
+    int n, cfgstat = 0;
     Stm32_Clock_Init(432, 25, 2, 9); // ʱ,216Mhz
     delay_init(216);                 // ʱʼ
     uart_init(108, 256000);          // ڳʼΪ115200
     usart3_init(54, 115200);
     LED_Init();                      // ʼLEDӵӲӿ
     rtkinit(&svr.rtk, &default_opt); // óʼ
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // enable DWT cycle counter (ubx decode time)
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
     init_raw(&svr.raw[0]);
-    svr.stream[0].type = STR_SERIAL;
-    svr.conv[0]->itype = STRFMT_UBX;
+    init_demux(&dmx, &svr.raw[0]);
+    dmx.rawfunc = rawfunc;
+    init_ubxcfg(&ubxcfg, ubxprofile, ubxprofile_len, 0, 216000000); // ջ,ACKʱ1s(DWT)
+    svr.raw[0].ubxcfg = &ubxcfg;
+    stropen(&svr.stream[0], STR_SERIAL, STR_MODE_RW, ""); // ջ(3)
     while (1)
     {
-        if (USART3_RX_STA & 0x8000)
+        if (cfgstat == 0 && (cfgstat = send_ubxcfg(&ubxcfg, usart3_write, DWT->CYCCNT)) != 0)
         {
-            if (led)
-                LED0(0);
-            else
-                LED0(1);
-            led = ~led;
-            len = USART3_RX_STA & 0X7FFF; // õݳ
-            for (t = 0; t < len; t++)
-                input_raw(&svr.raw[0], svr.conv[0]->itype, USART3_RX_BUF[t]);
-            USART3_RX_STA = 0;
-            if (ublox_raw_flag == 1)
-            {
-
-                time = gpst2utc(svr.raw[0].time);//GPSTתΪUTCʱ䣬
-                if (time.sec >= 0.995)
-                {
-                    time.time++;
-                    time.sec = 0.0;
-                }
-                time2epoch(time, ep);//1970.1.1ת
-
-                rtkpos(&svr.rtk, svr.raw[0].obs.data, svr.raw[0].obs.n, &svr.raw[0].nav);
-                //				outsol(Soluion,&svr.rtk.sol,svr.rtk.rb);
-                //				printf("GPGGA,%s\r\n",Soluion);
-                outnmea_gga(Soluion_GGA, &svr.rtk.sol);
-                outnmea_rmc(Soluion_RMC, &svr.rtk.sol);
-                outnmea_gsa(Soluion_GSA, &svr.rtk.sol, svr.rtk.ssat);
-                outnmea_gsv(Soluion_GSV, &svr.rtk.sol, svr.rtk.ssat);
-                printf("%s%s%s%s\r\n", Soluion_GGA, Soluion_RMC, Soluion_GSA, Soluion_GSV);
-                printf("ERROR,%s\r\n", svr.rtk.errbuf);
-
-                //				printf("SATNUM=%02d,%02.0f%02.0f%05.2f,\r\n",svr.raw[0].obs.n,svr.raw[0].time.time,svr.raw[0].time.sec);
-                printf("SATNUM=%02d,%02.0f%02.0f%05.2f,%02.0f%02.0f%02d*FF\r\n", svr.raw[0].obs.n, ep[3], ep[4], ep[5], ep[2], ep[1], (int)ep[0] % 100);
-                //				for(t=0;t<svr.raw[0].obs.n;t++)
-                //				{
-                //					printf("GPSSYS=%d*EE\r\n",svr.raw[0].obs.data[t].rcv);
-                //					if(svr.raw[0].obs.data[t].sat<33)
-                //					printf("GPSSYS=G%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
-                //					else if(svr.raw[0].obs.data[t].sat>=33&&svr.raw[0].obs.data[t].sat<57)
-                //					printf("GLOSYS=R%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-32,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
-                //					else if(svr.raw[0].obs.data[t].sat>=57&&svr.raw[0].obs.data[t].sat<84)
-                //					printf("GALSYS=E%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-56,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
-                //					else if(svr.raw[0].obs.data[t].sat>=84&&svr.raw[0].obs.data[t].sat<87)
-                //					printf("QZSSYS=J%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-83,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
-                //					else if(svr.raw[0].obs.data[t].sat>=87&&svr.raw[0].obs.data[t].sat<122)
-                //					printf("BDSSYS=C%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-86,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
-                //					else if(svr.raw[0].obs.data[t].sat>=122&&svr.raw[0].obs.data[t].sat<144)
-                //					printf("SBASYS=%02d,%06lf,%06lf,%06lf,%03d*EE\r\n",svr.raw[0].obs.data[t].sat-2,svr.raw[0].obs.data[t].L[0],svr.raw[0].obs.data[t].P[0],svr.raw[0].obs.data[t].D[0],svr.raw[0].obs.data[t].SNR[0]);
-                //						printf("week sec:%.3lf,%.8lf\r\n",svr.raw[0].nav.eph[svr.raw[0].obs.data[t].sat-1].A,svr.raw[0].nav.eph[svr.raw[0].obs.data[t].sat-1].e);
-                //				}
-                ublox_raw_flag = 0;
-                ublox_eph_flag = 0;
-            }
+            printf("UBXCFG,%d,%d,%d\r\n", ubxcfg.nack, ubxcfg.nnak, ubxcfg.ntout); // :ACK,NAK,ʱ
+        }
+        if ((n = strread(&svr.stream[0], buff, sizeof(buff))) > 0) // е
+        {
+            svr.raw[0].tarr = svr.stream[0].tarr; // ݵʱ(ж)
+            input_demux(&dmx, buff, n);
         }
     }
 }
@@ -0,0 +1,36 @@
+/* ubx cfg blob generated by ubxcfg from m8t.cfg (do not edit) */
+const unsigned char ubxprofile[] = {
+    /* CFG-PRT    1 0 0 2256 115200 7 1 0 0 */
+    0xB5, 0x62, 0x06, 0x00, 0x14, 0x00, 0x01, 0x00, 0x00, 0x00, 0xD0, 0x08,
+    0x00, 0x00, 0x00, 0xC2, 0x01, 0x00, 0x07, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xBE, 0x72,
+    /* CFG-RATE   1000 1 1 */
+    0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xE8, 0x03, 0x01, 0x00, 0x01, 0x00,
+    0x01, 0x39,
+    /* CFG-GNSS   0 0 32 7 0 8 16 0 16842753 1 1 3 0 16842753 2 4 8 0 16842753 3 8 16 0 16842753 4 0 8 0 50397184 5 0 3 0 84213761 6 8 14 0 16842752 */
+    0xB5, 0x62, 0x06, 0x3E, 0x3C, 0x00, 0x00, 0x00, 0x20, 0x07, 0x00, 0x08,
+    0x10, 0x00, 0x01, 0x00, 0x01, 0x01, 0x01, 0x01, 0x03, 0x00, 0x01, 0x00,
+    0x01, 0x01, 0x02, 0x04, 0x08, 0x00, 0x01, 0x00, 0x01, 0x01, 0x03, 0x08,
+    0x10, 0x00, 0x01, 0x00, 0x01, 0x01, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00,
+    0x01, 0x03, 0x05, 0x00, 0x03, 0x00, 0x01, 0x00, 0x05, 0x05, 0x06, 0x08,
+    0x0E, 0x00, 0x00, 0x00, 0x01, 0x01, 0x3A, 0x33,
+    /* CFG-MSG    2 21 0 1 0 0 0 0 */
+    0xB5, 0x62, 0x06, 0x01, 0x08, 0x00, 0x02, 0x15, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x27, 0x4B,
+    /* CFG-MSG    2 19 0 1 0 0 0 0 */
+    0xB5, 0x62, 0x06, 0x01, 0x08, 0x00, 0x02, 0x13, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x25, 0x3D,
+    /* CFG-MSG    1 7  0 1 0 0 0 0 */
+    0xB5, 0x62, 0x06, 0x01, 0x08, 0x00, 0x01, 0x07, 0x00, 0x01, 0x00, 0x00,
+    0x00, 0x00, 0x18, 0xE1,
+    /* CFG-MSG    1 34 0 0 0 0 0 0 */
+    0xB5, 0x62, 0x06, 0x01, 0x08, 0x00, 0x01, 0x22, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x32, 0x99,
+    /* CFG-MSG    1 53 0 0 0 0 0 0 */
+    0xB5, 0x62, 0x06, 0x01, 0x08, 0x00, 0x01, 0x35, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x45, 0x1E,
+    /* CFG-MSG    13 1 0 0 0 0 0 0 */
+    0xB5, 0x62, 0x06, 0x01, 0x08, 0x00, 0x0D, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x1D, 0x12,
+};
+const int ubxprofile_len = sizeof(ubxprofile); /* 9 frames */